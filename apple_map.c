@@ -1,10 +1,39 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
 #include "apple_map.h"
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define PREFETCH(address) __builtin_prefetch(address)
+#else
+#define PREFETCH(address) ((void)(address))
+#endif
+
+#ifdef APPLE_MAP_COUNTERS
+#define COUNT(map, counter, amount) ((map)->counters.counter += (amount))
+#else
+#define COUNT(map, counter, amount) ((void)(map))
+#endif
+
 typedef struct bucket bucket;
 
+typedef struct arena_chunk arena_chunk;
+
+typedef struct trace_log trace_log;
+
 /**
  * @brief      Hashmap is a data structure, that maps keys to values. Values in the
  *             apple map implementation are pointer values or integral types.
@@ -20,6 +49,28 @@ struct apple_map
   size_t capacity;
   size_t len;
   size_t tombstone_len;
+
+  /* Bytes per slot of the bucket array, sets leave out the value. */
+  size_t stride;
+  size_t value_size;
+
+  uint32_t flags;
+  uint32_t prefault_threads;
+  apple_map_allocator allocator;
+
+  arena_chunk *arena;
+  size_t arena_reserved;
+  size_t arena_used;
+  size_t arena_dead;
+
+  apple_map_resize_hook resize_hook;
+  void *resize_hook_user;
+
+  trace_log *trace;
+
+#ifdef APPLE_MAP_COUNTERS
+  apple_map_counters counters;
+#endif
 };
 
 typedef struct bucket
@@ -32,14 +83,155 @@ typedef struct bucket
   uintptr_t value;
 } bucket;
 
+/* Slots of a set end right before the value. A set is a hashmap without values, `apple_set`
+   itself is never defined, set pointers are only cast to hashmap ones. */
+#define SET_STRIDE offsetof(bucket, value)
+
+/* Values are stored inline from `value` on, padded so that the next slot stays aligned. */
+#define VALUE_ALIGNMENT 8
+
+/* Removed entries keep their slot, marked by a null key of this size, so probes go on past them. */
+#define TOMBSTONE_KEY_SIZE SIZE_MAX
+
+struct arena_chunk
+{
+  arena_chunk *next;
+
+  size_t capacity;
+  size_t used;
+  unsigned char data[];
+};
+
+static inline bucket *slot_at(apple_map *map, size_t index);
+
+static inline void *slot_value(bucket *entry);
+
+static inline void value_copy(apple_map *map, bucket *entry, bucket *from);
+
+static inline bool slot_empty(const bucket *entry);
+
 static bucket *resolve(apple_map *map, const void *key, size_t key_size, uint32_t hash);
 
+static inline uint32_t hash_key(apple_map *map, const void *key, size_t key_size);
+
 static inline uint32_t fnv_1a_hash(const unsigned char *data, size_t size);
 
+static inline uint64_t fnv_1a_hash_seeded(const unsigned char *data, size_t size, uint64_t seed);
+
+static bucket *emplace(apple_map *map, const void *key, size_t key_size, uint32_t hash, bool *inserted);
+
+static void *default_alloc(void *context, size_t size, size_t alignment);
+
+static void *default_zeroed_alloc(void *context, size_t size, size_t alignment);
+
+static void default_free(void *context, void *pointer, size_t size);
+
+static bucket *buckets_alloc(apple_map *map, size_t capacity);
+
+static void buckets_free(apple_map *map, bucket *buckets, size_t capacity);
+
+static inline bool buckets_mapped(apple_map *map, size_t capacity);
+
+static inline size_t buckets_size(apple_map *map, size_t capacity);
+
+static inline void account(ptrdiff_t delta);
+
+static inline uint64_t now_ns(void);
+
+static void *pages_alloc(size_t size, bool huge);
+
+static void pages_prefault(unsigned char *pages, size_t size, uint32_t threads_count);
+
+static void *prefault_range(void *argument);
+
+typedef struct slot_range slot_range;
+
+static void slot_ranges_run(apple_map *map, uint32_t threads_count, void (*visit)(slot_range *range),
+                            void *context);
+
+static uint32_t slot_ranges_len(apple_map *map, uint32_t threads_count);
+
+static void *slot_range_thread(void *argument);
+
+static void parallel_for_range(slot_range *range);
+
+static void parallel_reduce_range(slot_range *range);
+
+static void export_range(slot_range *range);
+
+static apple_map *map_new(const apple_map_config *config, size_t value_size);
+
+static apple_map *new_like(apple_map *like);
+
+static apple_map *clone_as(apple_map *map, apple_map *like);
+
+static bool merge_from(apple_map *map, apple_map *source, apple_map_conflict_callback conflict,
+                       apple_map_value_conflict_callback value_conflict, void *user);
+
+static void keep_value(const void *key, size_t key_size, void *value, const void *other_value,
+                       void *user);
+
+static apple_map *filter_keys(apple_map *map, apple_map *iterated, apple_map *probed, bool keep_found);
+
+static bool adopt_key(apple_map *map, bucket *entry);
+
+static bool copy_key(apple_map *map, bucket *entry);
+
+static inline bool keys_in_arena(apple_map *map);
+
+static void bury(apple_map *map, bucket *entry);
+
+static void entomb(apple_map *map, bucket *entry);
+
+static bool reserve(apple_map *map, size_t additional);
+
+static bool rehash(apple_map *map, size_t capacity);
+
 static bucket *resize_entry(apple_map *map, bucket *entry);
 
+static void *arena_copy(apple_map *map, const void *key, size_t key_size);
+
+static void arena_free(apple_map *map, arena_chunk *chunk);
+
+static bool arena_compact(apple_map *map);
+
+static inline void trace(apple_map *map, apple_map_trace_op op, const void *key, size_t key_size,
+                         uint32_t hash, uint64_t value);
+
+static void trace_append(trace_log *log, apple_map_trace_op op, const void *key, size_t key_size,
+                         uint32_t hash, uint64_t value);
+
+static void trace_write(trace_log *log, const void *data, size_t size);
+
+static bool trace_flush(trace_log *log);
+
+static size_t trace_size(const apple_map *map);
+
+static bool write_all(int fd, const void *data, size_t size);
+
+static inline uint64_t frozen_mix(uint64_t hash);
+
+static inline uint64_t frozen_slot(uint64_t hash, uint32_t displacement, uint64_t len);
+
+static bool frozen_build(apple_frozen_map *frozen, apple_map *map, uint64_t salt);
+
+static bool frozen_validate(const unsigned char *image, size_t image_size);
+
 const size_t DEFAULT_CAPACITY = 30;
 
+/* Entries of a merge or of a batch of set keys, whose home slots are fetched together. */
+#define MERGE_BATCH_LEN 64
+
+static apple_map_memory_hook memory_hook = NULL;
+static void *memory_hook_user = NULL;
+
+static const apple_map_allocator DEFAULT_ALLOCATOR = {
+    .alloc = default_alloc,
+    .zeroed_alloc = default_zeroed_alloc,
+    .free = default_free,
+    .context = NULL,
+};
+
 /**
  * @brief      Creates a new empty hashmap.
  * @returns    A newly allocated empty hashmap.
@@ -48,14 +240,51 @@ const size_t DEFAULT_CAPACITY = 30;
  */
 apple_map *apple_map_new(void)
 {
-  apple_map *map = malloc(sizeof(apple_map));
+  return apple_map_new_with_config(NULL);
+}
+
+/**
+ * @brief              Creates a new empty hashmap, configured by `config`.
+ * @param config       The configuration of the hashmap. `NULL` or a zero-initialized
+ *                     configuration give the same hashmap as `apple_map_new`.
+ * @returns            A newly allocated empty hashmap.
+ *
+ * @version            0.3.0
+ */
+apple_map *apple_map_new_with_config(const apple_map_config *config)
+{
+  return map_new(config, config != NULL && config->value_size != 0 ? config->value_size
+                                                                   : sizeof(uintptr_t));
+}
+
+static apple_map *map_new(const apple_map_config *config, size_t value_size)
+{
+  const apple_map_allocator *allocator = config != NULL && config->allocator != NULL
+                                             ? config->allocator
+                                             : &DEFAULT_ALLOCATOR;
+
+  apple_map *map = allocator->alloc(allocator->context, sizeof(apple_map), _Alignof(apple_map));
 
   if (map == NULL)
   {
     return NULL;
   }
 
-  map->buckets = calloc(DEFAULT_CAPACITY, sizeof(bucket));
+  map->allocator = *allocator;
+  map->flags = config != NULL ? config->flags : 0;
+  map->prefault_threads = config != NULL ? config->prefault_threads : 0;
+  map->value_size = value_size;
+  map->stride = SET_STRIDE + (value_size + VALUE_ALIGNMENT - 1) / VALUE_ALIGNMENT * VALUE_ALIGNMENT;
+  map->buckets = buckets_alloc(map, DEFAULT_CAPACITY);
+
+  if (map->buckets == NULL)
+  {
+    allocator->free(allocator->context, map, sizeof(apple_map));
+    return NULL;
+  }
+
+  account(sizeof(apple_map));
+
   map->first = NULL;
   map->last = (bucket *)&map->first;
 
@@ -63,374 +292,3512 @@ apple_map *apple_map_new(void)
   map->len = 0;
   map->tombstone_len = 0;
 
+  map->arena = NULL;
+  map->arena_reserved = 0;
+  map->arena_used = 0;
+  map->arena_dead = 0;
+
+  map->resize_hook = NULL;
+  map->resize_hook_user = NULL;
+
+  map->trace = NULL;
+
+#ifdef APPLE_MAP_COUNTERS
+  memset(&map->counters, 0, sizeof(apple_map_counters));
+#endif
+
   return map;
 }
 
 /**
- * @brief              Frees the hashmap object and inner buckets.
- * @details            This function doesn't free the key-value pairs. You can achieve that by
- *                     using `apple_map_iter` with callback freeing the hashmap entries.
- * @param map          The hashmap object to free.
+ * @brief              Removes every entry from the hashmap, but keeps its capacity, so it can be
+ *                     refilled without growing it again.
+ * @details            Only the slots that were ever filled are reset when they are a small share of
+ *                     the bucket array, so clearing a sparse hashmap costs as much as its entries.
+ *                     Otherwise the whole array is zeroed, a mapped one by dropping its pages. Keys
+ *                     copied by the hashmap are released, but their memory is kept for new keys.
+ *                     Like `apple_map_free`, it doesn't free the key-value pairs themselves.
+ * @param map          The hashmap to clear.
  *
- * @version            0.1.0
+ * @version            0.3.0
  */
-inline void apple_map_free(apple_map *map)
+void apple_map_clear(apple_map *map)
 {
-  free(map->buckets);
-  free(map);
+  trace(map, APPLE_MAP_TRACE_CLEAR, NULL, 0, 0, 0);
+
+  if (map->len * 4 < map->capacity)
+  {
+    /* Tombstones stay linked until a rehash, so the list reaches every slot ever filled. */
+    bucket *current = map->first;
+
+    while (current != NULL)
+    {
+      bucket *next = current->next;
+
+      memset(current, 0, map->stride);
+      current = next;
+    }
+  }
+  else if (!buckets_mapped(map, map->capacity) ||
+           madvise(map->buckets, buckets_size(map, map->capacity), MADV_DONTNEED) != 0)
+  {
+    memset(map->buckets, 0, map->capacity * map->stride);
+  }
+
+  map->first = NULL;
+  map->last = (bucket *)&map->first;
+
+  map->len = 0;
+  map->tombstone_len = 0;
+
+  /* Keep the newest chunk of keys around for the keys of new entries. */
+  if (map->arena != NULL)
+  {
+    arena_free(map, map->arena->next);
+
+    map->arena->next = NULL;
+    map->arena->used = 0;
+  }
+
+  map->arena_used = 0;
+  map->arena_dead = 0;
 }
 
 /**
- * @brief              Resolves a key-value pair from the hashmap.
- *
- * @param map          The hashmap, from which the key-value pair will be resolved.
- * @param key          The key to resolve.
- * @param key_size     The size of the key.
- * @param out_value    The reference to a value to store the resolved value.
+ * @brief              Creates a copy of the hashmap with the same configuration, capacity and
+ *                     insertion order, by copying its bucket array slot by slot and relocating the
+ *                     order links, without hashing or probing a single key.
+ * @details            Keys are shared with the original, unless it owns them or holds some of them
+ *                     in its own memory, like the keys read by `apple_map_load_stream`, then the
+ *                     copy owns copies of them. Hooks and traces aren't copied.
+ * @param map          The hashmap to copy.
  *
- * @returns            The resolved value.
+ * @returns            The copy or `NULL` if the memory for it couldn't be allocated.
  *
- * @version            0.1.0
+ * @version            0.3.0
  */
-bool apple_map_get(apple_map *map, const void *key, size_t key_size, uintptr_t *out_value)
+apple_map *apple_map_clone(apple_map *map)
 {
-  uint32_t hash = fnv_1a_hash(key, key_size);
-  bucket *entry = resolve(map, key, key_size, hash);
+  return clone_as(map, map);
+}
 
-  *out_value = entry->value;
+static apple_map *new_like(apple_map *like)
+{
+  apple_map_config config = {
+      .flags = like->flags,
+      .allocator = &like->allocator,
+      .prefault_threads = like->prefault_threads,
+  };
 
-  return entry->key != NULL;
+  return map_new(&config, like->value_size);
 }
 
-static bucket *resolve(apple_map *map, const void *key, size_t key_size, uint32_t hash)
+static apple_map *clone_as(apple_map *map, apple_map *like)
 {
-  uint32_t index = hash % map->capacity;
+  apple_map *clone = new_like(like);
 
-  while (true)
+  if (clone == NULL)
   {
-    bucket *entry = &map->buckets[index];
-
-    bool null_key = entry->key == NULL;
-    bool null_value = entry->value == 0;
+    return NULL;
+  }
 
-    if ((null_key && null_value) ||
-        (!null_key &&
-         entry->key_size == key_size &&
-         entry->hash == hash &&
-         memcmp(entry->key, key, key_size) == 0))
-    {
-      return entry;
-    }
+  bucket *buckets = buckets_alloc(clone, map->capacity);
 
-    index = (index + 1) % map->capacity;
+  if (buckets == NULL)
+  {
+    apple_map_free(clone);
+    return NULL;
   }
-}
 
-static inline uint32_t fnv_1a_hash(const unsigned char *data, size_t size)
-{
-  size_t blocks_count = size / 8;
-  uint64_t hash = 2166136261u;
+  buckets_free(clone, clone->buckets, clone->capacity);
 
-  for (size_t i = 0; i < blocks_count; i++)
+  clone->buckets = buckets;
+  clone->capacity = map->capacity;
+
+  ptrdiff_t shift = (unsigned char *)buckets - (unsigned char *)map->buckets;
+
+  /* Links are relocated in the same pass, that copies the slots. */
+  for (size_t i = 0; i < map->capacity; i++)
   {
-    hash ^= (uint64_t)data[0] << 0 | (uint64_t)data[1] << 8 |
-            (uint64_t)data[2] << 16 | (uint64_t)data[3] << 24 |
-            (uint64_t)data[4] << 32 | (uint64_t)data[5] << 40 |
-            (uint64_t)data[6] << 48 | (uint64_t)data[7] << 56;
-    hash *= 0xbf58476d1ce4e5b9;
-    data += 8;
+    bucket *slot = slot_at(clone, i);
+
+    memcpy(slot, slot_at(map, i), map->stride);
+
+    if (slot->next != NULL)
+      slot->next = (bucket *)((unsigned char *)slot->next + shift);
   }
 
-  uint64_t last = size & 0xff;
-  switch (size % 8)
+  clone->first = map->first != NULL ? (bucket *)((unsigned char *)map->first + shift) : NULL;
+  clone->last = map->last != (bucket *)&map->first ? (bucket *)((unsigned char *)map->last + shift)
+                                                   : (bucket *)&clone->first;
+
+  clone->len = map->len;
+  clone->tombstone_len = map->tombstone_len;
+
+  /* Keys in the arena of the original go away with it, so they can't be shared. */
+  if ((clone->flags & APPLE_MAP_OWN_KEYS) || keys_in_arena(map))
   {
-  case 7:
-    last |= (uint64_t)data[6] << 56;
-  case 6:
-    last |= (uint64_t)data[5] << 48;
-  case 5:
-    last |= (uint64_t)data[4] << 40;
-  case 4:
-    last |= (uint64_t)data[3] << 32;
-  case 3:
-    last |= (uint64_t)data[2] << 24;
-  case 2:
-    last |= (uint64_t)data[1] << 16;
-  case 1:
-    last |= (uint64_t)data[0] << 8;
-    hash ^= last;
-    hash *= 0xd6e8feb86659fd93;
+    for (bucket *current = clone->first; current != NULL; current = current->next)
+    {
+      if (current->key == NULL)
+        continue;
+
+      current->key = arena_copy(clone, current->key, current->key_size);
+
+      if (current->key == NULL)
+      {
+        apple_map_free(clone);
+        return NULL;
+      }
+    }
   }
 
-  return (uint32_t)(hash ^ hash >> 32);
+  return clone;
 }
 
-const float MAX_CAPACITY_PERCENTAGE = 0.75;
-
 /**
- * @brief            Inserts a key-value pair into the hashmap.
- * @details          Function doesn't copy a key, so you should guarantee its lifetime.
+ * @brief              Inserts every entry of `source` into the hashmap, reusing the hashes
+ *                     cached in `source`. The hashmap is grown once up front and the home slots of
+ *                     every batch of entries are fetched ahead of inserting them.
+ * @details            Keys are shared with `source`, unless the hashmap was created with
+ *                     `APPLE_MAP_OWN_KEYS` or `source` holds some of its keys in its own memory,
+ *                     like the keys read by `apple_map_load_stream`, then they are copied.
+ *                     Otherwise you should guarantee their lifetime.
  *
- * @param map        The hashmap, into which the key-value pair will be inserted.
- * @param key        The key, to insert into the hashmap.
- * @param key_size   The size of the key.
- * @param value      The value, to insert into the hashmap.
+ * @param map          The hashmap to merge into.
+ * @param source       The hashmap to merge from. It isn't changed.
+ * @param conflict     The callback, that picks the value of a key present in both hashmaps, or
+ *                     `NULL` to take the value from `source`. Values stored inline, that are larger
+ *                     than `uintptr_t`, can't be picked by it, merge such hashmaps with
+ *                     `apple_map_merge_values`.
+ * @param user         User pointer is a pointer that you can use in the `conflict` callback.
  *
- * @version          0.1.0
+ * @returns            `true` if every entry was merged.
+ *                     `false` if a key couldn't be copied, the values of the two hashmaps differ
+ *                     in size or `conflict` was given for values larger than `uintptr_t`, which
+ *                     leaves the hashmap unchanged.
+ *
+ * @version            0.3.0
  */
-void apple_map_insert(apple_map *map, const void *key, size_t key_size, uintptr_t value)
+bool apple_map_merge(apple_map *map, apple_map *source, apple_map_conflict_callback conflict,
+                     void *user)
 {
-  if (map->len + 1 > MAX_CAPACITY_PERCENTAGE * map->capacity)
-  {
-    apple_map_resize(map);
-  }
-
-  uint32_t hash = fnv_1a_hash(key, key_size);
-  bucket *entry = resolve(map, key, key_size, hash);
-
-  if (entry->key == NULL)
+  /* The callback would only pick the first word of every value. */
+  if (conflict != NULL && map->value_size > sizeof(uintptr_t))
   {
-    map->last->next = entry;
-    map->last = entry;
-
-    entry->next = NULL;
-
-    map->len++;
-
-    entry->key = key;
-    entry->key_size = key_size;
-
-    entry->hash = hash;
+    return false;
   }
 
-  entry->value = value;
+  return merge_from(map, source, conflict, NULL, user);
 }
 
 /**
- * @brief              Tries to resolve a key-value pair from the hashmap. If it fails, it adds the
- *                     entry into the hashmap, with the value read from `out_in`. If it doesn't, `out_in`
- *                     will be set to the value from the hashmap entry successfully resolved by key.
+ * @brief              Same as `apple_map_merge`, but a key present in both hashmaps is resolved by
+ *                     updating its value in place, so whole values stored inline can be combined,
+ *                     like the aggregation states of two partial results.
  *
- * @param map          The hashmap, from which the key-value pair will be resolved.
- * @param key          The key to resolve.
- * @param key_size     The size of the key.
- * @param out_in       The reference to a value to store it in a new hashmap entry or the
- *                     value that will be set to the value of successfully resolved entry.
+ * @param map          The hashmap to merge into.
+ * @param source       The hashmap to merge from. It isn't changed.
+ * @param conflict     The callback, that updates the value of a key present in both hashmaps, or
+ *                     `NULL` to take the value from `source`.
+ * @param user         User pointer is a pointer that you can use in the `conflict` callback.
  *
- * @returns            `true` if the key-value pair already exists.
- *                     `false` otherwise.
+ * @returns            `true` if every entry was merged.
+ *                     `false` if a key couldn't be copied or the values of the two hashmaps differ
+ *                     in size.
  *
- * @version            0.1.0
+ * @version            0.3.0
  */
-bool apple_map_get_or_insert(apple_map *map, const void *key, size_t key_size, uintptr_t *out_in)
+bool apple_map_merge_values(apple_map *map, apple_map *source,
+                            apple_map_value_conflict_callback conflict, void *user)
 {
-  if (map->len + 1 > MAX_CAPACITY_PERCENTAGE * map->capacity)
+  return merge_from(map, source, NULL, conflict, user);
+}
+
+static bool merge_from(apple_map *map, apple_map *source, apple_map_conflict_callback conflict,
+                       apple_map_value_conflict_callback value_conflict, void *user)
+{
+  bucket *batch[MERGE_BATCH_LEN];
+  bool merged = true;
+
+  if (source->value_size != map->value_size || !reserve(map, apple_map_len(source)))
   {
-    apple_map_resize(map);
+    return false;
   }
 
-  uint32_t hash = fnv_1a_hash(key, key_size);
-  bucket *entry = resolve(map, key, key_size, hash);
+  bucket *current = source->first;
 
-  if (entry->key == NULL)
+  while (current != NULL)
   {
-    map->last->next = entry;
-    map->last = entry;
-    entry->next = NULL;
+    size_t batch_len = 0;
 
-    map->len++;
+    /* The capacity doesn't change while merging, so home slots can be fetched ahead. */
+    for (; current != NULL && batch_len < MERGE_BATCH_LEN; current = current->next)
+    {
+      if (current->key == NULL)
+        continue;
 
-    entry->value = *out_in;
-    entry->key = key;
-    entry->key_size = key_size;
-    entry->hash = hash;
+      PREFETCH(slot_at(map, current->hash % map->capacity));
+      batch[batch_len++] = current;
+    }
 
-    return false;
+    for (size_t i = 0; i < batch_len; i++)
+    {
+      bucket *from = batch[i];
+      bool inserted;
+      bucket *entry = emplace(map, from->key, from->key_size, from->hash, &inserted);
+
+      if (inserted)
+      {
+        bool adopted = keys_in_arena(source) ? copy_key(map, entry) : adopt_key(map, entry);
+
+        if (!adopted)
+        {
+          merged = false;
+          continue;
+        }
+
+        value_copy(map, entry, from);
+      }
+      else if (value_conflict != NULL)
+      {
+        value_conflict(entry->key, entry->key_size, slot_value(entry), slot_value(from), user);
+      }
+      else if (conflict != NULL)
+      {
+        entry->value = conflict(entry->key, entry->key_size, entry->value, from->value, user);
+      }
+      else
+      {
+        value_copy(map, entry, from);
+      }
+
+      trace(map, APPLE_MAP_TRACE_INSERT, entry->key, entry->key_size, entry->hash, entry->value);
+    }
   }
 
-  *out_in = entry->value;
-
-  return true;
+  return merged;
 }
 
 /**
- * @brief            Removes a key-value pair resolved by key from the hashmap.
- * @param map        The hashmap, from which the key-value pair will be removed.
- * @param  key       The key, via which entry is resolved.
- * @param  key_size  The size of the key.
+ * @brief              Creates a hashmap of the entries of `map`, whose keys are also in `other`.
+ * @details            The smaller of the two hashmaps is walked and its cached hashes are looked
+ *                     up in the other one in batches, with the home slots fetched ahead. The new
+ *                     hashmap is configured like `map` and its keys are shared with `map`, unless
+ *                     it owns them or `map` holds them in its own memory.
  *
- * @version          0.1.0
+ * @param map          The hashmap, whose entries are kept.
+ * @param other        The hashmap, whose keys select the entries.
+ *
+ * @returns            The new hashmap or `NULL` if the memory for it couldn't be allocated.
+ *
+ * @version            0.3.0
  */
-void apple_map_remove(apple_map *map, const void *key, size_t key_size)
+apple_map *apple_map_intersect(apple_map *map, apple_map *other)
 {
-  uint32_t hash = fnv_1a_hash(key, key_size);
-  bucket *entry = resolve(map, key, key_size, hash);
-
-  if (entry->key != NULL)
+  if (apple_map_len(other) < apple_map_len(map))
   {
-    entry->key = NULL;
-    entry->value = 0xDEAD;
-
-    map->tombstone_len++;
+    return filter_keys(map, other, map, true);
   }
+
+  return filter_keys(map, map, other, true);
 }
 
 /**
- * @brief              Removes a key-value pair resolved by key from the hashmap. But unlike
- *                     `apple_map_remove`, it will free the key-value pair's data via the `callback`.
- * @param map          The hashmap, from which the key-value pair will be removed.
- * @param  key         The key, via which entry is resolved.
- * @param  key_size    The size of the key.
- * @param  callback    The callback, that will be called to free the key-value pair.
- * @param  user        User pointer is a pointer that you can use in the `callback`.
+ * @brief              Creates a hashmap of the entries of `map`, whose keys aren't in `other`.
+ * @details            `map` is walked and its cached hashes are looked up in `other` in batches,
+ *                     with the home slots fetched ahead. The new hashmap is configured like `map`
+ *                     and its keys are shared with `map`, unless it owns them or `map` holds them
+ *                     in its own memory.
  *
- * @version            0.1.0
+ * @param map          The hashmap, whose entries are kept.
+ * @param other        The hashmap, whose keys are excluded.
+ *
+ * @returns            The new hashmap or `NULL` if the memory for it couldn't be allocated.
+ *
+ * @version            0.3.0
  */
-void apple_map_remove_free(apple_map *map, const void *key, size_t key_size,
-                           apple_map_callback callback, void *user)
+apple_map *apple_map_difference(apple_map *map, apple_map *other)
 {
-  uint32_t hash = fnv_1a_hash(key, key_size);
-  bucket *entry = resolve(map, key, key_size, hash);
+  return filter_keys(map, map, other, false);
+}
 
-  if (entry->key != NULL)
+/**
+ * @brief              Creates a hashmap of the entries of both hashmaps. Keys present in both keep
+ *                     the value from `map`.
+ * @details            The larger of the two hashmaps is cloned and the smaller one is merged into
+ *                     the clone, reusing its cached hashes, so the order of the entries follows the
+ *                     larger hashmap. The new hashmap is configured like `map` and its keys are
+ *                     shared with the inputs, unless it owns them.
+ *
+ * @param map          The first hashmap, whose values win.
+ * @param other        The second hashmap.
+ *
+ * @returns            The new hashmap or `NULL` if the memory for it couldn't be allocated or the
+ *                     values of the two hashmaps differ in size.
+ *
+ * @version            0.3.0
+ */
+apple_map *apple_map_union(apple_map *map, apple_map *other)
+{
+  if (other->value_size != map->value_size)
   {
-    callback((void *)entry->key, entry->key_size, entry->value, user);
+    return NULL;
+  }
+
+  bool other_larger = apple_map_len(other) > apple_map_len(map);
+  apple_map *result = clone_as(other_larger ? other : map, map);
+
+  if (result == NULL)
+  {
+    return NULL;
+  }
 
-    entry->key = NULL;
-    entry->value = 0xDEAD;
+  bool merged = other_larger ? apple_map_merge(result, map, NULL, NULL)
+                             : apple_map_merge_values(result, other, keep_value, NULL);
 
-    map->tombstone_len++;
+  if (!merged)
+  {
+    apple_map_free(result);
+    return NULL;
   }
+
+  return result;
 }
 
-/**
- * @brief              Similiar to `apple_map_insert`, but when trying to overwrite a hashmap entry,
- *                     it will free the old entry's data via callback using `callback`.
- * @param map          The hashmap, into which the key-value pair will be soft-inserted.
- * @param key          The key, to insert into the hashmap.
- * @param key_size     The size of the key.
- * @param value        The value, to insert into the hashmap.
- * @param callback     The callback, that will be called when the key-value pair already exists.
- * @param user         User pointer is a pointer that you can use in the `callback`.
- *
- * @version            0.1.0
- */
-void apple_map_soft_insert(apple_map *map, const void *key, size_t key_size,
-                           uintptr_t value, apple_map_callback callback, void *user)
+static void keep_value(const void *key, size_t key_size, void *value, const void *other_value,
+                       void *user)
 {
-  if (map->len + 1 > MAX_CAPACITY_PERCENTAGE * map->capacity)
+  (void)key;
+  (void)key_size;
+  (void)value;
+  (void)other_value;
+  (void)user;
+}
+
+static apple_map *filter_keys(apple_map *map, apple_map *iterated, apple_map *probed, bool keep_found)
+{
+  bucket *batch[MERGE_BATCH_LEN];
+  apple_map *result = new_like(map);
+
+  if (result == NULL)
   {
-    apple_map_resize(map);
+    return NULL;
   }
 
-  uint32_t hash = fnv_1a_hash(key, key_size);
-  bucket *entry = resolve(map, key, key_size, hash);
+  if (!reserve(result, apple_map_len(iterated)))
+  {
+    apple_map_free(result);
+    return NULL;
+  }
 
-  if (entry->key == NULL)
+  bucket *current = iterated->first;
+
+  while (current != NULL)
   {
-    map->last->next = entry;
-    map->last = entry;
-    entry->next = NULL;
+    size_t batch_len = 0;
 
-    map->len++;
+    for (; current != NULL && batch_len < MERGE_BATCH_LEN; current = current->next)
+    {
+      if (current->key == NULL)
+        continue;
 
-    entry->key = key;
-    entry->key_size = key_size;
-    entry->value = value;
-    entry->hash = hash;
+      PREFETCH(slot_at(probed, current->hash % probed->capacity));
+      batch[batch_len++] = current;
+    }
 
-    return;
+    for (size_t i = 0; i < batch_len; i++)
+    {
+      bucket *found = resolve(probed, batch[i]->key, batch[i]->key_size, batch[i]->hash);
+
+      if ((found->key != NULL) != keep_found)
+        continue;
+
+      /* Entries always come from `map`, whichever of the two is walked. */
+      bucket *from = iterated == map ? batch[i] : found;
+      bool inserted;
+      bucket *entry = emplace(result, from->key, from->key_size, from->hash, &inserted);
+      bool adopted = !inserted || (keys_in_arena(map) ? copy_key(result, entry) : adopt_key(result, entry));
+
+      if (!adopted)
+      {
+        apple_map_free(result);
+        return NULL;
+      }
+
+      value_copy(result, entry, from);
+    }
   }
 
-  callback((void *)entry->key, key_size, entry->value, user);
+  return result;
+}
 
-  entry->key = key;
-  entry->value = value;
+/**
+ * @brief              Frees the hashmap object and inner buckets.
+ * @details            This function doesn't free the key-value pairs. You can achieve that by
+ *                     using `apple_map_iter` with callback freeing the hashmap entries. Keys
+ *                     copied by the hashmap itself are freed here. A running trace is flushed.
+ * @param map          The hashmap object to free.
+ *
+ * @version            0.1.0
+ */
+inline void apple_map_free(apple_map *map)
+{
+  apple_map_allocator allocator = map->allocator;
+
+  if (map->trace != NULL)
+  {
+    apple_map_trace_stop(map);
+  }
+
+  arena_free(map, map->arena);
+  buckets_free(map, map->buckets, map->capacity);
+  allocator.free(allocator.context, map, sizeof(apple_map));
+
+  account(-(ptrdiff_t)sizeof(apple_map));
 }
 
 /**
- * @brief            Returns the number of entries in the hashmap.
- * @returns          The number of entries in the hashmap.
+ * @brief      Creates a new empty set.
+ * @returns    A newly allocated empty set.
  *
- * @version          0.1.0
+ * @version    0.3.0
  */
-inline size_t apple_map_len(apple_map *map)
+apple_set *apple_set_new(void)
 {
-  return map->len - map->tombstone_len;
+  return apple_set_new_with_config(NULL);
 }
 
-const float RESIZE_FACTOR_PERCENTAGE = 2;
+/**
+ * @brief              Creates a new empty set, configured by `config` like a hashmap.
+ * @param config       The configuration of the set. `NULL` or a zero-initialized configuration
+ *                     give the same set as `apple_set_new`.
+ * @returns            A newly allocated empty set.
+ *
+ * @version            0.3.0
+ */
+apple_set *apple_set_new_with_config(const apple_map_config *config)
+{
+  return (apple_set *)map_new(config, 0);
+}
 
 /**
- * @brief              Resizes the hashmap to a new capacity when the hashmap is full.
- * @param map          The hashmap to iterate.
+ * @brief            Inserts a key into the set.
+ * @details          Function doesn't copy a key, unless the set was created with
+ *                   `APPLE_MAP_OWN_KEYS`, so you should guarantee its lifetime.
  *
- * @version            0.1.0
+ * @param set        The set, into which the key will be inserted.
+ * @param key        The key, to insert into the set.
+ * @param key_size   The size of the key.
+ *
+ * @returns          `true` if the key was inserted.
+ *                   `false` if the set already had it.
+ *
+ * @version          0.3.0
  */
-void apple_map_resize(apple_map *map)
+bool apple_set_insert(apple_set *set, const void *key, size_t key_size)
 {
-  bucket *old_buckets = map->buckets;
+  apple_map *map = (apple_map *)set;
+  uint32_t hash = hash_key(map, key, key_size);
 
-  map->capacity *= RESIZE_FACTOR_PERCENTAGE;
-  map->buckets = calloc(map->capacity, sizeof(bucket));
+  trace(map, APPLE_MAP_TRACE_INSERT, key, key_size, hash, 0);
 
-  map->last = (bucket *)&map->first;
+  bool inserted;
+  bucket *entry = emplace(map, key, key_size, hash, &inserted);
 
-  map->len -= map->tombstone_len;
-  map->tombstone_len = 0;
+  return inserted && adopt_key(map, entry);
+}
 
-  do
+/**
+ * @brief              Inserts `n` keys into the set. The set is grown once up front, the keys are
+ *                     hashed in batches and the home slots of a batch are fetched ahead of
+ *                     probing them, so cache misses overlap instead of following each other.
+ *
+ * @param set          The set, into which the keys will be inserted.
+ * @param keys         The keys to insert.
+ * @param sizes        The sizes of the keys.
+ * @param n            The number of keys.
+ *
+ * @returns            The number of keys, that weren't in the set yet.
+ *
+ * @version            0.3.0
+ */
+size_t apple_set_insert_many(apple_set *set, const void *const *keys, const size_t *sizes, size_t n)
+{
+  apple_map *map = (apple_map *)set;
+  uint32_t hashes[MERGE_BATCH_LEN];
+  size_t inserted_len = 0;
+
+  reserve(map, n);
+
+  for (size_t start = 0; start < n; start += MERGE_BATCH_LEN)
   {
-    bucket *current = map->last->next;
+    size_t batch_len = n - start < MERGE_BATCH_LEN ? n - start : MERGE_BATCH_LEN;
 
-    if (current->key == NULL)
+    for (size_t i = 0; i < batch_len; i++)
     {
-      map->last->next = current->next;
-      continue;
+      hashes[i] = hash_key(map, keys[start + i], sizes[start + i]);
+      PREFETCH(slot_at(map, hashes[i] % map->capacity));
     }
 
-    map->last->next = resize_entry(map, map->last->next);
-    map->last = map->last->next;
-  } while (map->last->next != NULL);
+    for (size_t i = 0; i < batch_len; i++)
+    {
+      const void *key = keys[start + i];
+      size_t key_size = sizes[start + i];
+
+      trace(map, APPLE_MAP_TRACE_INSERT, key, key_size, hashes[i], 0);
+
+      bool inserted;
+      bucket *entry = emplace(map, key, key_size, hashes[i], &inserted);
 
-  free(old_buckets);
+      inserted_len += inserted && adopt_key(map, entry);
+    }
+  }
+
+  return inserted_len;
 }
 
-static bucket *resize_entry(apple_map *map, bucket *entry)
+/**
+ * @brief            Checks whether the set has the key.
+ *
+ * @param set        The set to search.
+ * @param key        The key to search for.
+ * @param key_size   The size of the key.
+ *
+ * @returns          `true` if the set has the key.
+ *
+ * @version          0.3.0
+ */
+bool apple_set_contains(apple_set *set, const void *key, size_t key_size)
 {
-  uint32_t idx = entry->hash % map->capacity;
+  apple_map *map = (apple_map *)set;
+  uint32_t hash = hash_key(map, key, key_size);
 
-  while (true)
+  trace(map, APPLE_MAP_TRACE_GET, key, key_size, hash, 0);
+
+  return resolve(map, key, key_size, hash)->key != NULL;
+}
+
+/**
+ * @brief              Checks which of `n` keys the set has, hashing them in batches and fetching
+ *                     the home slots of a batch ahead of probing them.
+ *
+ * @param set          The set to search.
+ * @param keys         The keys to search for.
+ * @param sizes        The sizes of the keys.
+ * @param n            The number of keys.
+ * @param out_found    The array of `n` flags to store whether each key was found. Can be `NULL`.
+ *
+ * @returns            The number of keys found.
+ *
+ * @version            0.3.0
+ */
+size_t apple_set_contains_many(apple_set *set, const void *const *keys, const size_t *sizes, size_t n,
+                               bool *out_found)
+{
+  apple_map *map = (apple_map *)set;
+  uint32_t hashes[MERGE_BATCH_LEN];
+  size_t found_len = 0;
+
+  for (size_t start = 0; start < n; start += MERGE_BATCH_LEN)
   {
-    bucket *new_entry = &map->buckets[idx];
+    size_t batch_len = n - start < MERGE_BATCH_LEN ? n - start : MERGE_BATCH_LEN;
 
-    if (entry->key == NULL)
+    for (size_t i = 0; i < batch_len; i++)
     {
-      *new_entry = *entry;
-      return new_entry;
+      hashes[i] = hash_key(map, keys[start + i], sizes[start + i]);
+      PREFETCH(slot_at(map, hashes[i] % map->capacity));
     }
 
-    idx = (idx + 1) % map->capacity;
+    for (size_t i = 0; i < batch_len; i++)
+    {
+      const void *key = keys[start + i];
+      size_t key_size = sizes[start + i];
+
+      trace(map, APPLE_MAP_TRACE_GET, key, key_size, hashes[i], 0);
+
+      bool found = resolve(map, key, key_size, hashes[i])->key != NULL;
+
+      if (out_found != NULL)
+        out_found[start + i] = found;
+
+      found_len += found;
+    }
   }
+
+  return found_len;
 }
 
 /**
- * @brief              Iterates through the hashmap, using the `callback`.
- * @param map          The hashmap to iterate.
- * @param callback     The callback, that will be called on each entry.
- * @param user         User pointer is a pointer that you can use in the `callback`.
+ * @brief            Removes a key from the set.
  *
- * @version            0.2.0
+ * @param set        The set, from which the key will be removed.
+ * @param key        The key to remove.
+ * @param key_size   The size of the key.
+ *
+ * @returns          `true` if the key was removed.
+ *                   `false` if the set didn't have it.
+ *
+ * @version          0.3.0
  */
-void apple_map_iter(apple_map *map, apple_map_callback callback, void *user)
+bool apple_set_remove(apple_set *set, const void *key, size_t key_size)
 {
-  bucket *current = map->first;
+  apple_map *map = (apple_map *)set;
+  uint32_t hash = hash_key(map, key, key_size);
+  bucket *entry = resolve(map, key, key_size, hash);
 
-  while (current != NULL)
+  trace(map, APPLE_MAP_TRACE_REMOVE, key, key_size, hash, 0);
+
+  if (entry->key == NULL)
   {
-    if (current->key != NULL)
-      callback((void *)current->key, current->key_size, current->value, user);
+    return false;
+  }
 
-    current = current->next;
+  bury(map, entry);
+
+  return true;
+}
+
+/**
+ * @brief      Returns the number of keys in the set.
+ *
+ * @version    0.3.0
+ */
+size_t apple_set_len(apple_set *set)
+{
+  return apple_map_len((apple_map *)set);
+}
+
+/**
+ * @brief              Advances the cursor to the next key of the set, like `apple_map_next`.
+ *
+ * @param set          The set to iterate.
+ * @param cursor       The cursor, initialized by `apple_map_cursor_init`.
+ * @param out_key      The reference to store the key in. Can be `NULL`.
+ * @param out_key_size The reference to store the key size in. Can be `NULL`.
+ *
+ * @returns            `true` if the cursor moved to a key.
+ *                     `false` if there are no more keys.
+ *
+ * @version            0.3.0
+ */
+bool apple_set_next(apple_set *set, apple_map_cursor *cursor, const void **out_key, size_t *out_key_size)
+{
+  /* Slots of a set have no value, so it must not be read. */
+  return apple_map_next((apple_map *)set, cursor, out_key, out_key_size, NULL);
+}
+
+/**
+ * @brief              Removes every key from the set, but keeps its capacity, like
+ *                     `apple_map_clear`.
+ * @param set          The set to clear.
+ *
+ * @version            0.3.0
+ */
+void apple_set_clear(apple_set *set)
+{
+  apple_map_clear((apple_map *)set);
+}
+
+/**
+ * @brief              Frees the set object and inner buckets. Keys copied by the set itself are
+ *                     freed here too.
+ * @param set          The set object to free.
+ *
+ * @version            0.3.0
+ */
+void apple_set_free(apple_set *set)
+{
+  apple_map_free((apple_map *)set);
+}
+
+static void *default_alloc(void *context, size_t size, size_t alignment)
+{
+  (void)context;
+
+  if (alignment <= _Alignof(max_align_t))
+  {
+    return malloc(size);
+  }
+
+  return aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+}
+
+static void *default_zeroed_alloc(void *context, size_t size, size_t alignment)
+{
+  if (alignment <= _Alignof(max_align_t))
+  {
+    return calloc(1, size);
+  }
+
+  void *pointer = default_alloc(context, size, alignment);
+
+  if (pointer != NULL)
+  {
+    memset(pointer, 0, size);
+  }
+
+  return pointer;
+}
+
+static void default_free(void *context, void *pointer, size_t size)
+{
+  (void)context;
+  (void)size;
+
+  free(pointer);
+}
+
+#define HUGE_PAGE_SIZE ((size_t)2 << 20)
+
+static bucket *buckets_alloc(apple_map *map, size_t capacity)
+{
+  bucket *buckets;
+
+  if (buckets_mapped(map, capacity))
+  {
+    size_t size = capacity * map->stride;
+
+    buckets = pages_alloc(size, map->flags & APPLE_MAP_HUGE_PAGES);
+
+    if (buckets != NULL && map->prefault_threads > 0)
+    {
+      pages_prefault((unsigned char *)buckets, size, map->prefault_threads);
+    }
   }
+  else
+  {
+    buckets = map->allocator.zeroed_alloc(map->allocator.context, capacity * map->stride,
+                                          _Alignof(bucket));
+  }
+
+  if (buckets != NULL)
+  {
+    account(buckets_size(map, capacity));
+  }
+
+  return buckets;
+}
+
+static void buckets_free(apple_map *map, bucket *buckets, size_t capacity)
+{
+  account(-(ptrdiff_t)buckets_size(map, capacity));
+
+  if (buckets_mapped(map, capacity))
+  {
+    munmap(buckets, buckets_size(map, capacity));
+    return;
+  }
+
+  map->allocator.free(map->allocator.context, buckets, capacity * map->stride);
+}
+
+static inline bool buckets_mapped(apple_map *map, size_t capacity)
+{
+  /*
+   * Fresh anonymous pages are already zero and are only faulted in once the rehash writes them,
+   * so large arrays skip the zero-fill of `calloc`, unless a custom allocator owns them.
+   */
+  return capacity * map->stride >= HUGE_PAGE_SIZE &&
+         ((map->flags & APPLE_MAP_HUGE_PAGES) || map->allocator.zeroed_alloc == default_zeroed_alloc);
+}
+
+static inline size_t buckets_size(apple_map *map, size_t capacity)
+{
+  size_t size = capacity * map->stride;
+
+  if (buckets_mapped(map, capacity))
+  {
+    return (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+  }
+
+  return size;
+}
+
+static inline uint64_t now_ns(void)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return (uint64_t)now.tv_sec * 1000000000u + now.tv_nsec;
+}
+
+#ifdef APPLE_MAP_COUNTERS
+/**
+ * @brief              Reads the hot path counters of the hashmap.
+ * @param map          The hashmap to inspect.
+ * @param out_counters The reference to counters to fill.
+ *
+ * @version            0.3.0
+ */
+void apple_map_read_counters(apple_map *map, apple_map_counters *out_counters)
+{
+  *out_counters = map->counters;
+}
+
+/**
+ * @brief              Sets all hot path counters of the hashmap to zero.
+ * @param map          The hashmap, which counters will be reset.
+ *
+ * @version            0.3.0
+ */
+void apple_map_reset_counters(apple_map *map)
+{
+  memset(&map->counters, 0, sizeof(apple_map_counters));
+}
+#endif
+
+static inline void account(ptrdiff_t delta)
+{
+  if (memory_hook != NULL)
+  {
+    memory_hook(delta, memory_hook_user);
+  }
+}
+
+/**
+ * @brief              Reports the memory used by the hashmap.
+ * @param map          The hashmap to inspect.
+ * @param out_report   The reference to a report to fill.
+ *
+ * @version            0.3.0
+ */
+void apple_map_memory_usage(apple_map *map, apple_map_memory_report *out_report)
+{
+  size_t len = apple_map_len(map);
+
+  out_report->buckets_bytes = buckets_size(map, map->capacity);
+  out_report->keys_bytes = map->arena_reserved;
+  /* Borrowed keys of a hashmap, that also read a stream, are counted as dead when removed. */
+  out_report->keys_live_bytes = map->arena_used > map->arena_dead ? map->arena_used - map->arena_dead : 0;
+  out_report->metadata_bytes = sizeof(apple_map);
+  out_report->trace_bytes = trace_size(map);
+  out_report->total_bytes = out_report->buckets_bytes + out_report->keys_bytes +
+                            out_report->metadata_bytes + out_report->trace_bytes;
+  out_report->bytes_per_entry = len > 0 ? (double)out_report->total_bytes / len : 0;
+}
+
+/**
+ * @brief              Installs a process-wide hook, that is called every time any hashmap
+ *                     allocates or frees memory, with the change in bytes.
+ * @details            The hook is global and isn't synchronized, so install it before
+ *                     hashmaps are created on other threads. Memory allocated before the hook
+ *                     was installed is not reported, but freeing it is, so a running total of
+ *                     the deltas is only correct if the hook is installed before any hashmap is
+ *                     created.
+ * @param hook         The hook to call or `NULL` to remove it.
+ * @param user         User pointer is a pointer that you can use in the `hook`.
+ *
+ * @version            0.3.0
+ */
+void apple_map_set_memory_hook(apple_map_memory_hook hook, void *user)
+{
+  memory_hook = hook;
+  memory_hook_user = user;
+}
+
+/**
+ * @brief              Computes occupancy and probing statistics of the hashmap by scanning its
+ *                     whole bucket array.
+ * @param map          The hashmap to inspect.
+ * @param out_stats    The reference to a report to fill.
+ *
+ * @version            0.3.0
+ */
+void apple_map_stats(apple_map *map, apple_map_stats_report *out_stats)
+{
+  size_t capacity = map->capacity;
+
+  memset(out_stats, 0, sizeof(apple_map_stats_report));
+
+  out_stats->capacity = capacity;
+  out_stats->len = apple_map_len(map);
+  out_stats->tombstones = map->tombstone_len;
+  out_stats->load_factor = (double)map->len / capacity;
+
+  size_t empty = capacity;
+  size_t hit_probes = 0;
+
+  for (size_t i = 0; i < capacity; i++)
+  {
+    bucket *entry = slot_at(map, i);
+
+    if (entry->key == NULL)
+    {
+      if (slot_empty(entry))
+        empty = i;
+
+      continue;
+    }
+
+    size_t probe = (i + capacity - entry->hash % capacity) % capacity + 1;
+
+    hit_probes += probe;
+
+    if (probe > out_stats->max_hit_probe)
+      out_stats->max_hit_probe = probe;
+
+    out_stats->probe_histogram[probe < APPLE_MAP_STATS_HISTOGRAM_LEN ? probe - 1 : APPLE_MAP_STATS_HISTOGRAM_LEN - 1]++;
+  }
+
+  if (out_stats->len > 0)
+  {
+    out_stats->average_hit_probe = (double)hit_probes / out_stats->len;
+  }
+
+  if (empty == capacity)
+  {
+    out_stats->average_miss_probe = out_stats->max_miss_probe = capacity;
+    out_stats->max_cluster = capacity;
+    out_stats->cluster_histogram[APPLE_MAP_STATS_HISTOGRAM_LEN - 1] = 1;
+    return;
+  }
+
+  /*
+   * Walk backwards from an empty slot, so the run of taken slots in front of every slot is
+   * known when the slot is reached. A miss starting at a slot examines that run plus one slot.
+   */
+  size_t run = 0;
+  size_t miss_probes = 0;
+
+  for (size_t k = 1; k <= capacity; k++)
+  {
+    bucket *entry = slot_at(map, (empty + capacity - k) % capacity);
+
+    if (slot_empty(entry))
+    {
+      if (run > 0)
+      {
+        size_t bin = 0;
+
+        while (bin + 1 < APPLE_MAP_STATS_HISTOGRAM_LEN && run >> (bin + 1) != 0)
+          bin++;
+
+        out_stats->cluster_histogram[bin]++;
+
+        if (run > out_stats->max_cluster)
+          out_stats->max_cluster = run;
+      }
+
+      run = 0;
+    }
+    else
+    {
+      run++;
+    }
+
+    miss_probes += run + 1;
+
+    if (run + 1 > out_stats->max_miss_probe)
+      out_stats->max_miss_probe = run + 1;
+  }
+
+  out_stats->average_miss_probe = (double)miss_probes / capacity;
+}
+
+static void *pages_alloc(size_t size, bool huge)
+{
+  size_t length = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+
+  if (!huge)
+  {
+    void *pages = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    return pages != MAP_FAILED ? pages : NULL;
+  }
+
+#ifdef MAP_HUGETLB
+  /* Explicit huge pages only work when the administrator reserved a pool of them. */
+  void *pages = mmap(NULL, length, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+  if (pages != MAP_FAILED)
+  {
+    return pages;
+  }
+#endif
+
+  /* Transparent huge pages need a 2 MiB aligned range, so map one page more and trim it. */
+  unsigned char *raw = mmap(NULL, length + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+  if (raw == MAP_FAILED)
+  {
+    return NULL;
+  }
+
+  unsigned char *aligned = (unsigned char *)(((uintptr_t)raw + HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(HUGE_PAGE_SIZE - 1));
+  size_t head = aligned - raw;
+
+  if (head > 0)
+  {
+    munmap(raw, head);
+  }
+
+  if (HUGE_PAGE_SIZE - head > 0)
+  {
+    munmap(aligned + length, HUGE_PAGE_SIZE - head);
+  }
+
+#ifdef MADV_HUGEPAGE
+  madvise(aligned, length, MADV_HUGEPAGE);
+#endif
+
+  return aligned;
+}
+
+typedef struct prefault_task
+{
+  unsigned char *start;
+  size_t size;
+} prefault_task;
+
+#define PREFAULT_MAX_THREADS 64
+
+static void pages_prefault(unsigned char *pages, size_t size, uint32_t threads_count)
+{
+  pthread_t threads[PREFAULT_MAX_THREADS];
+  prefault_task tasks[PREFAULT_MAX_THREADS];
+
+  if (threads_count > PREFAULT_MAX_THREADS)
+  {
+    threads_count = PREFAULT_MAX_THREADS;
+  }
+
+  size_t page_size = sysconf(_SC_PAGESIZE);
+  size_t pages_count = (size + page_size - 1) / page_size;
+  size_t chunk = (pages_count + threads_count - 1) / threads_count * page_size;
+
+  uint32_t started = 0;
+
+  for (uint32_t i = 0; i < threads_count; i++)
+  {
+    size_t offset = i * chunk;
+
+    if (offset >= size)
+    {
+      break;
+    }
+
+    tasks[i].start = pages + offset;
+    tasks[i].size = size - offset < chunk ? size - offset : chunk;
+
+    if (pthread_create(&threads[started], NULL, prefault_range, &tasks[i]) != 0)
+    {
+      prefault_range(&tasks[i]);
+      continue;
+    }
+
+    started++;
+  }
+
+  for (uint32_t i = 0; i < started; i++)
+  {
+    pthread_join(threads[i], NULL);
+  }
+}
+
+static void *prefault_range(void *argument)
+{
+  prefault_task *task = argument;
+
+#ifdef MADV_POPULATE_WRITE
+  if (madvise(task->start, task->size, MADV_POPULATE_WRITE) == 0)
+  {
+    return NULL;
+  }
+#endif
+
+  size_t page_size = sysconf(_SC_PAGESIZE);
+
+  for (size_t offset = 0; offset < task->size; offset += page_size)
+  {
+    ((volatile unsigned char *)task->start)[offset] = 0;
+  }
+
+  return NULL;
+}
+
+/**
+ * @brief              Resolves a key-value pair from the hashmap.
+ *
+ * @param map          The hashmap, from which the key-value pair will be resolved.
+ * @param key          The key to resolve.
+ * @param key_size     The size of the key.
+ * @param out_value    The reference to a value to store the resolved value.
+ *
+ * @returns            The resolved value.
+ *
+ * @version            0.1.0
+ */
+bool apple_map_get(apple_map *map, const void *key, size_t key_size, uintptr_t *out_value)
+{
+  uint32_t hash = hash_key(map, key, key_size);
+  bucket *entry = resolve(map, key, key_size, hash);
+
+  trace(map, APPLE_MAP_TRACE_GET, key, key_size, hash, 0);
+
+  *out_value = entry->value;
+
+  return entry->key != NULL;
+}
+
+static bucket *resolve(apple_map *map, const void *key, size_t key_size, uint32_t hash)
+{
+  uint32_t index = hash % map->capacity;
+
+  while (true)
+  {
+    bucket *entry = slot_at(map, index);
+
+    COUNT(map, probes, 1);
+
+    if (slot_empty(entry))
+    {
+      return entry;
+    }
+
+    if (entry->key != NULL && entry->key_size == key_size)
+    {
+      if (entry->hash != hash)
+      {
+        COUNT(map, hash_rejects, 1);
+      }
+      else
+      {
+        COUNT(map, compares, 1);
+
+        if (memcmp(entry->key, key, key_size) == 0)
+        {
+          return entry;
+        }
+      }
+    }
+
+    index = (index + 1) % map->capacity;
+  }
+}
+
+static inline bucket *slot_at(apple_map *map, size_t index)
+{
+  return (bucket *)((unsigned char *)map->buckets + index * map->stride);
+}
+
+static inline void *slot_value(bucket *entry)
+{
+  return (unsigned char *)entry + offsetof(bucket, value);
+}
+
+static inline void value_copy(apple_map *map, bucket *entry, bucket *from)
+{
+  /* The padding goes along, since the `uintptr_t` functions write a whole word of short values. */
+  memcpy(slot_value(entry), slot_value(from), map->stride - SET_STRIDE);
+}
+
+static inline bool slot_empty(const bucket *entry)
+{
+  return entry->key == NULL && entry->key_size != TOMBSTONE_KEY_SIZE;
+}
+
+static inline uint32_t hash_key(apple_map *map, const void *key, size_t key_size)
+{
+  COUNT(map, hashes, 1);
+
+  return fnv_1a_hash(key, key_size);
+}
+
+static inline uint32_t fnv_1a_hash(const unsigned char *data, size_t size)
+{
+  uint64_t hash = fnv_1a_hash_seeded(data, size, 2166136261u);
+
+  return (uint32_t)(hash ^ hash >> 32);
+}
+
+static inline uint64_t fnv_1a_hash_seeded(const unsigned char *data, size_t size, uint64_t seed)
+{
+  size_t blocks_count = size / 8;
+  uint64_t hash = seed;
+
+  for (size_t i = 0; i < blocks_count; i++)
+  {
+    hash ^= (uint64_t)data[0] << 0 | (uint64_t)data[1] << 8 |
+            (uint64_t)data[2] << 16 | (uint64_t)data[3] << 24 |
+            (uint64_t)data[4] << 32 | (uint64_t)data[5] << 40 |
+            (uint64_t)data[6] << 48 | (uint64_t)data[7] << 56;
+    hash *= 0xbf58476d1ce4e5b9;
+    data += 8;
+  }
+
+  uint64_t last = size & 0xff;
+  switch (size % 8)
+  {
+  case 7:
+    last |= (uint64_t)data[6] << 56;
+  case 6:
+    last |= (uint64_t)data[5] << 48;
+  case 5:
+    last |= (uint64_t)data[4] << 40;
+  case 4:
+    last |= (uint64_t)data[3] << 32;
+  case 3:
+    last |= (uint64_t)data[2] << 24;
+  case 2:
+    last |= (uint64_t)data[1] << 16;
+  case 1:
+    last |= (uint64_t)data[0] << 8;
+    hash ^= last;
+    hash *= 0xd6e8feb86659fd93;
+  }
+
+  return hash;
+}
+
+const float MAX_CAPACITY_PERCENTAGE = 0.75;
+
+/**
+ * @brief            Inserts a key-value pair into the hashmap.
+ * @details          Function doesn't copy a key, unless the hashmap was created with
+ *                   `APPLE_MAP_OWN_KEYS`, so you should guarantee its lifetime.
+ *
+ * @param map        The hashmap, into which the key-value pair will be inserted.
+ * @param key        The key, to insert into the hashmap.
+ * @param key_size   The size of the key.
+ * @param value      The value, to insert into the hashmap.
+ *
+ * @version          0.1.0
+ */
+void apple_map_insert(apple_map *map, const void *key, size_t key_size, uintptr_t value)
+{
+  uint32_t hash = hash_key(map, key, key_size);
+
+  trace(map, APPLE_MAP_TRACE_INSERT, key, key_size, hash, value);
+
+  bool inserted;
+  bucket *entry = emplace(map, key, key_size, hash, &inserted);
+
+  if (inserted && !adopt_key(map, entry))
+  {
+    return;
+  }
+
+  entry->value = value;
+}
+
+/**
+ * @brief              Tries to resolve a key-value pair from the hashmap. If it fails, it adds the
+ *                     entry into the hashmap, with the value read from `out_in`. If it doesn't, `out_in`
+ *                     will be set to the value from the hashmap entry successfully resolved by key.
+ *
+ * @param map          The hashmap, from which the key-value pair will be resolved.
+ * @param key          The key to resolve.
+ * @param key_size     The size of the key.
+ * @param out_in       The reference to a value to store it in a new hashmap entry or the
+ *                     value that will be set to the value of successfully resolved entry.
+ *
+ * @returns            `true` if the key-value pair already exists.
+ *                     `false` otherwise. The new entry was inserted then, unless the hashmap was
+ *                     created with `APPLE_MAP_OWN_KEYS` and the key couldn't be copied, which
+ *                     leaves the key absent.
+ *
+ * @version            0.1.0
+ */
+bool apple_map_get_or_insert(apple_map *map, const void *key, size_t key_size, uintptr_t *out_in)
+{
+  uint32_t hash = hash_key(map, key, key_size);
+
+  trace(map, APPLE_MAP_TRACE_GET_OR_INSERT, key, key_size, hash, *out_in);
+
+  bool inserted;
+  bucket *entry = emplace(map, key, key_size, hash, &inserted);
+
+  if (inserted)
+  {
+    if (adopt_key(map, entry))
+    {
+      entry->value = *out_in;
+    }
+
+    return false;
+  }
+
+  *out_in = entry->value;
+
+  return true;
+}
+
+/**
+ * @brief              Resolves the value slot of a key, inserting a new entry with a zero value
+ *                     when the key is absent. The returned pointer can be used to read and update
+ *                     the value in place, without hashing and probing the key a second time.
+ * @details            The pointer stays valid until the next call that mutates the hashmap.
+ *                     Function doesn't copy a key, unless the hashmap was created with
+ *                     `APPLE_MAP_OWN_KEYS`, so you should guarantee its lifetime.
+ *
+ * @param map          The hashmap, in which the key will be resolved or inserted.
+ * @param key          The key to resolve.
+ * @param key_size     The size of the key.
+ * @param out_inserted The reference to a flag, that is set to `true` if a new entry was inserted
+ *                     and to `false` if the entry already existed or couldn't be inserted. Can be
+ *                     `NULL`.
+ *
+ * @returns            The pointer to the value of the entry or `NULL` if the key couldn't be copied.
+ *
+ * @version            0.3.0
+ */
+uintptr_t *apple_map_entry(apple_map *map, const void *key, size_t key_size, bool *out_inserted)
+{
+  uint32_t hash = hash_key(map, key, key_size);
+
+  trace(map, APPLE_MAP_TRACE_ENTRY, key, key_size, hash, 0);
+
+  bool inserted;
+  bucket *entry = emplace(map, key, key_size, hash, &inserted);
+
+  if (out_inserted != NULL)
+  {
+    *out_inserted = false;
+  }
+
+  if (inserted && !adopt_key(map, entry))
+  {
+    return NULL;
+  }
+
+  if (out_inserted != NULL)
+  {
+    *out_inserted = inserted;
+  }
+
+  return &entry->value;
+}
+
+/**
+ * @brief              Resolves the value of a key in place.
+ * @details            The pointer stays valid until the next call that mutates the hashmap.
+ *
+ * @param map          The hashmap, from which the value will be resolved.
+ * @param key          The key to resolve.
+ * @param key_size     The size of the key.
+ *
+ * @returns            The pointer to the `value_size` bytes of the value, stored inline in the
+ *                     slot, or `NULL` if the hashmap doesn't have the key.
+ *
+ * @version            0.3.0
+ */
+void *apple_map_get_ptr(apple_map *map, const void *key, size_t key_size)
+{
+  uint32_t hash = hash_key(map, key, key_size);
+  bucket *entry = resolve(map, key, key_size, hash);
+
+  trace(map, APPLE_MAP_TRACE_GET, key, key_size, hash, 0);
+
+  return entry->key != NULL ? slot_value(entry) : NULL;
+}
+
+/**
+ * @brief            Inserts a key-value pair into the hashmap, copying the `value_size` bytes of
+ *                   the value into the slot.
+ * @details          Function doesn't copy a key, unless the hashmap was created with
+ *                   `APPLE_MAP_OWN_KEYS`, so you should guarantee its lifetime.
+ *
+ * @param map        The hashmap, into which the key-value pair will be inserted.
+ * @param key        The key, to insert into the hashmap.
+ * @param key_size   The size of the key.
+ * @param value      The value to copy.
+ *
+ * @returns          `true` if the key-value pair was stored.
+ *                   `false` if the key couldn't be copied.
+ *
+ * @version          0.3.0
+ */
+bool apple_map_insert_value(apple_map *map, const void *key, size_t key_size, const void *value)
+{
+  uint32_t hash = hash_key(map, key, key_size);
+
+  trace(map, APPLE_MAP_TRACE_INSERT, key, key_size, hash, 0);
+
+  bool inserted;
+  bucket *entry = emplace(map, key, key_size, hash, &inserted);
+
+  if (inserted && !adopt_key(map, entry))
+  {
+    return false;
+  }
+
+  memcpy(slot_value(entry), value, map->value_size);
+
+  return true;
+}
+
+/**
+ * @brief              Same as `apple_map_entry`, but the returned pointer addresses the whole
+ *                     value stored inline in the slot. Values of new entries are zeroed.
+ *
+ * @param map          The hashmap, in which the key will be resolved or inserted.
+ * @param key          The key to resolve.
+ * @param key_size     The size of the key.
+ * @param out_inserted The reference to a flag, that is set to `true` if a new entry was inserted
+ *                     and to `false` if the entry already existed or couldn't be inserted. Can be
+ *                     `NULL`.
+ *
+ * @returns            The pointer to the `value_size` bytes of the value or `NULL` if the key
+ *                     couldn't be copied.
+ *
+ * @version            0.3.0
+ */
+void *apple_map_entry_ptr(apple_map *map, const void *key, size_t key_size, bool *out_inserted)
+{
+  return apple_map_entry(map, key, key_size, out_inserted);
+}
+
+static bucket *emplace(apple_map *map, const void *key, size_t key_size, uint32_t hash, bool *inserted)
+{
+  if (map->len + 1 > MAX_CAPACITY_PERCENTAGE * map->capacity)
+  {
+    apple_map_resize(map);
+  }
+
+  bucket *entry = resolve(map, key, key_size, hash);
+
+  *inserted = entry->key == NULL;
+
+  if (*inserted)
+  {
+    map->last->next = entry;
+    map->last = entry;
+    entry->next = NULL;
+
+    map->len++;
+
+    /* Empty slots are all zeros, the value included. */
+    entry->key = key;
+    entry->key_size = key_size;
+    entry->hash = hash;
+  }
+
+  return entry;
+}
+
+static bool adopt_key(apple_map *map, bucket *entry)
+{
+  if ((map->flags & APPLE_MAP_OWN_KEYS) == 0)
+  {
+    return true;
+  }
+
+  return copy_key(map, entry);
+}
+
+static bool copy_key(apple_map *map, bucket *entry)
+{
+  const void *copy = arena_copy(map, entry->key, entry->key_size);
+
+  /* The key never reached the arena, so it doesn't count as a dead key. */
+  if (copy == NULL)
+  {
+    entomb(map, entry);
+    return false;
+  }
+
+  entry->key = copy;
+
+  return true;
+}
+
+/* Owned keys and keys read from a stream are copies in the arena, which is freed with the hashmap. */
+static inline bool keys_in_arena(apple_map *map)
+{
+  return map->arena != NULL;
+}
+
+static void bury(apple_map *map, bucket *entry)
+{
+  if (keys_in_arena(map))
+  {
+    map->arena_dead += entry->key_size;
+  }
+
+  entomb(map, entry);
+}
+
+static void entomb(apple_map *map, bucket *entry)
+{
+  entry->key = NULL;
+  entry->key_size = TOMBSTONE_KEY_SIZE;
+
+  map->tombstone_len++;
+}
+
+/**
+ * @brief            Removes a key-value pair resolved by key from the hashmap.
+ * @param map        The hashmap, from which the key-value pair will be removed.
+ * @param  key       The key, via which entry is resolved.
+ * @param  key_size  The size of the key.
+ *
+ * @version          0.1.0
+ */
+void apple_map_remove(apple_map *map, const void *key, size_t key_size)
+{
+  uint32_t hash = hash_key(map, key, key_size);
+  bucket *entry = resolve(map, key, key_size, hash);
+
+  trace(map, APPLE_MAP_TRACE_REMOVE, key, key_size, hash, 0);
+
+  if (entry->key != NULL)
+  {
+    bury(map, entry);
+  }
+}
+
+/**
+ * @brief              Removes a key-value pair resolved by key from the hashmap. But unlike
+ *                     `apple_map_remove`, it will free the key-value pair's data via the `callback`.
+ * @param map          The hashmap, from which the key-value pair will be removed.
+ * @param  key         The key, via which entry is resolved.
+ * @param  key_size    The size of the key.
+ * @param  callback    The callback, that will be called to free the key-value pair.
+ * @param  user        User pointer is a pointer that you can use in the `callback`.
+ *
+ * @version            0.1.0
+ */
+void apple_map_remove_free(apple_map *map, const void *key, size_t key_size,
+                           apple_map_callback callback, void *user)
+{
+  uint32_t hash = hash_key(map, key, key_size);
+  bucket *entry = resolve(map, key, key_size, hash);
+
+  trace(map, APPLE_MAP_TRACE_REMOVE, key, key_size, hash, 0);
+
+  if (entry->key != NULL)
+  {
+    callback((void *)entry->key, entry->key_size, entry->value, user);
+
+    bury(map, entry);
+  }
+}
+
+/**
+ * @brief              Similiar to `apple_map_insert`, but when trying to overwrite a hashmap entry,
+ *                     it will free the old entry's data via callback using `callback`.
+ * @param map          The hashmap, into which the key-value pair will be soft-inserted.
+ * @param key          The key, to insert into the hashmap.
+ * @param key_size     The size of the key.
+ * @param value        The value, to insert into the hashmap.
+ * @param callback     The callback, that will be called when the key-value pair already exists.
+ * @param user         User pointer is a pointer that you can use in the `callback`.
+ *
+ * @version            0.1.0
+ */
+void apple_map_soft_insert(apple_map *map, const void *key, size_t key_size,
+                           uintptr_t value, apple_map_callback callback, void *user)
+{
+  uint32_t hash = hash_key(map, key, key_size);
+
+  trace(map, APPLE_MAP_TRACE_INSERT, key, key_size, hash, value);
+
+  bool inserted;
+  bucket *entry = emplace(map, key, key_size, hash, &inserted);
+
+  if (inserted)
+  {
+    if (adopt_key(map, entry))
+    {
+      entry->value = value;
+    }
+
+    return;
+  }
+
+  callback((void *)entry->key, key_size, entry->value, user);
+
+  /* An owned key is already an equal copy, only a borrowed key is replaced. */
+  if ((map->flags & APPLE_MAP_OWN_KEYS) == 0)
+  {
+    entry->key = key;
+  }
+
+  entry->value = value;
+}
+
+/**
+ * @brief            Returns the number of entries in the hashmap.
+ * @returns          The number of entries in the hashmap.
+ *
+ * @version          0.1.0
+ */
+inline size_t apple_map_len(apple_map *map)
+{
+  return map->len - map->tombstone_len;
+}
+
+const float RESIZE_FACTOR_PERCENTAGE = 2;
+
+/**
+ * @brief              Resizes the hashmap to a new capacity when the hashmap is full.
+ * @param map          The hashmap to iterate.
+ *
+ * @version            0.1.0
+ */
+void apple_map_resize(apple_map *map)
+{
+  rehash(map, map->capacity * RESIZE_FACTOR_PERCENTAGE);
+}
+
+/**
+ * @brief              Grows the hashmap once, so that `additional` more entries can be inserted
+ *                     without resizing it again.
+ * @param map          The hashmap to grow.
+ * @param additional   The number of entries, that are about to be inserted.
+ *
+ * @returns            `true` if the hashmap can take the entries without resizing.
+ *                     `false` if a bucket array for that many entries can't be sized or allocated.
+ *                     The hashmap is left as it was then.
+ *
+ * @version            0.3.0
+ */
+bool apple_map_reserve(apple_map *map, size_t additional)
+{
+  trace(map, APPLE_MAP_TRACE_RESERVE, NULL, 0, 0, additional);
+
+  return reserve(map, additional);
+}
+
+/* Growing ahead of bulk operations isn't traced, their insertions are. */
+static bool reserve(apple_map *map, size_t additional)
+{
+  /* Larger bucket arrays don't even fit into the address space. */
+  size_t max_capacity = SIZE_MAX / map->stride;
+
+  if (additional > max_capacity - map->len)
+  {
+    return false;
+  }
+
+  if (map->len + additional <= MAX_CAPACITY_PERCENTAGE * map->capacity)
+  {
+    return true;
+  }
+
+  size_t needed = apple_map_len(map) + additional;
+  size_t capacity = map->capacity;
+
+  while (needed > MAX_CAPACITY_PERCENTAGE * capacity)
+  {
+    if (capacity > max_capacity / RESIZE_FACTOR_PERCENTAGE)
+    {
+      return false;
+    }
+
+    capacity *= RESIZE_FACTOR_PERCENTAGE;
+  }
+
+  return rehash(map, capacity);
+}
+
+static bool rehash(apple_map *map, size_t capacity)
+{
+  apple_map_resize_event event = {
+      .phase = APPLE_MAP_RESIZE_BEFORE,
+      .old_capacity = map->capacity,
+      .new_capacity = capacity,
+      .len = apple_map_len(map),
+      .tombstones = map->tombstone_len,
+  };
+
+  if (map->resize_hook != NULL)
+  {
+    map->resize_hook(map, &event, map->resize_hook_user);
+  }
+
+  uint64_t started = 0;
+
+#ifndef APPLE_MAP_COUNTERS
+  if (map->resize_hook != NULL)
+#endif
+  {
+    started = now_ns();
+  }
+
+  event.phase = APPLE_MAP_RESIZE_AFTER;
+
+  bucket *new_buckets = buckets_alloc(map, capacity);
+
+  if (new_buckets == NULL)
+  {
+    if (map->resize_hook != NULL)
+    {
+      event.new_capacity = map->capacity;
+      event.elapsed_ns = now_ns() - started;
+
+      map->resize_hook(map, &event, map->resize_hook_user);
+    }
+
+    return false;
+  }
+
+  bucket *old_buckets = map->buckets;
+  size_t old_capacity = map->capacity;
+
+  map->capacity = capacity;
+  map->buckets = new_buckets;
+
+  map->last = (bucket *)&map->first;
+
+  map->len -= map->tombstone_len;
+  map->tombstone_len = 0;
+
+  while (map->last->next != NULL)
+  {
+    bucket *current = map->last->next;
+
+    if (current->key == NULL)
+    {
+      map->last->next = current->next;
+      continue;
+    }
+
+    map->last->next = resize_entry(map, current);
+    map->last = map->last->next;
+  }
+
+  buckets_free(map, old_buckets, old_capacity);
+
+  /* Relocate the owned keys once a quarter of the arena is taken by removed keys. */
+  if ((map->flags & APPLE_MAP_OWN_KEYS) && map->arena_dead * 4 >= map->arena_used &&
+      map->arena_dead > 0)
+  {
+    event.keys_compacted = arena_compact(map);
+  }
+
+  uint64_t elapsed = started != 0 ? now_ns() - started : 0;
+
+  COUNT(map, resizes, 1);
+  COUNT(map, resize_ns, elapsed);
+
+  if (map->resize_hook != NULL)
+  {
+    event.entries_moved = map->len;
+    event.elapsed_ns = elapsed;
+
+    map->resize_hook(map, &event, map->resize_hook_user);
+  }
+
+  return true;
+}
+
+/**
+ * @brief              Installs a hook, that is called right before and right after the bucket
+ *                     array of the hashmap is rebuilt, either to grow it or to drop tombstones.
+ * @param map          The hashmap to observe.
+ * @param hook         The hook to call or `NULL` to remove it.
+ * @param user         User pointer is a pointer that you can use in the `hook`.
+ *
+ * @version            0.3.0
+ */
+void apple_map_set_resize_hook(apple_map *map, apple_map_resize_hook hook, void *user)
+{
+  map->resize_hook = hook;
+  map->resize_hook_user = user;
+}
+
+static bucket *resize_entry(apple_map *map, bucket *entry)
+{
+  uint32_t idx = entry->hash % map->capacity;
+
+  while (true)
+  {
+    bucket *new_entry = slot_at(map, idx);
+
+    if (new_entry->key == NULL)
+    {
+      memcpy(new_entry, entry, map->stride);
+      return new_entry;
+    }
+
+    idx = (idx + 1) % map->capacity;
+  }
+}
+
+/**
+ * @brief              Iterates through the hashmap, using the `callback`.
+ * @details            The callback may remove the entry it was called with, but nothing else may
+ *                     change the hashmap during the iteration, since a resize would free the
+ *                     entries being walked. Use `apple_map_retain` to filter entries.
+ * @param map          The hashmap to iterate.
+ * @param callback     The callback, that will be called on each entry.
+ * @param user         User pointer is a pointer that you can use in the `callback`.
+ *
+ * @version            0.2.0
+ */
+void apple_map_iter(apple_map *map, apple_map_callback callback, void *user)
+{
+  bucket *current = map->first;
+
+  while (current != NULL)
+  {
+    if (current->key != NULL)
+      callback((void *)current->key, current->key_size, current->value, user);
+
+    current = current->next;
+  }
+}
+
+/**
+ * @brief              Positions the cursor before the first entry of any hashmap.
+ * @param cursor       The cursor to initialize.
+ * @param order        The order, in which the cursor visits the entries.
+ *
+ * @version            0.3.0
+ */
+void apple_map_cursor_init(apple_map_cursor *cursor, apple_map_cursor_order order)
+{
+  cursor->order = order;
+  cursor->entry = NULL;
+  cursor->index = 0;
+  cursor->positioned = false;
+}
+
+/**
+ * @brief              Advances the cursor to the next entry of the hashmap.
+ * @details            Unlike `apple_map_iter`, the caller drives the iteration, so it can stop at
+ *                     any entry and walk several hashmaps in lockstep. Stopping early needs no
+ *                     cleanup. Entries removed before the cursor reaches them are skipped. Anything
+ *                     that resizes the hashmap, an insertion included, invalidates the cursor.
+ *
+ * @param map          The hashmap to iterate.
+ * @param cursor       The cursor, initialized by `apple_map_cursor_init`.
+ * @param out_key      The reference to store the key of the entry in. Can be `NULL`.
+ * @param out_key_size The reference to store the key size of the entry in. Can be `NULL`.
+ * @param out_value    The reference to store the value of the entry in. Can be `NULL`.
+ *
+ * @returns            `true` if the cursor moved to an entry.
+ *                     `false` if there are no more entries.
+ *
+ * @version            0.3.0
+ */
+bool apple_map_next(apple_map *map, apple_map_cursor *cursor, const void **out_key,
+                    size_t *out_key_size, uintptr_t *out_value)
+{
+  bucket *entry = NULL;
+
+  if (cursor->order == APPLE_MAP_SLOT_ORDER)
+  {
+    while (cursor->index < map->capacity)
+    {
+      bucket *slot = slot_at(map, cursor->index++);
+
+      if (slot->key != NULL)
+      {
+        entry = slot;
+        break;
+      }
+    }
+  }
+  else
+  {
+    /* Same trick as `map->last`: `next` is the first field of a bucket. */
+    bucket *current = cursor->entry != NULL ? cursor->entry : (bucket *)&map->first;
+
+    while (current->next != NULL)
+    {
+      current = current->next;
+
+      if (current->key != NULL)
+      {
+        entry = current;
+        break;
+      }
+    }
+
+    cursor->entry = current;
+  }
+
+  cursor->positioned = entry != NULL;
+
+  if (entry == NULL)
+  {
+    return false;
+  }
+
+  if (cursor->order == APPLE_MAP_SLOT_ORDER)
+  {
+    cursor->entry = entry;
+  }
+
+  if (out_key != NULL)
+    *out_key = entry->key;
+
+  if (out_key_size != NULL)
+    *out_key_size = entry->key_size;
+
+  if (out_value != NULL)
+    *out_value = entry->value;
+
+  return true;
+}
+
+/**
+ * @brief              Removes the entry the cursor is at, without hashing or probing its key.
+ *                     The cursor stays valid and `apple_map_next` moves on to the following entry.
+ *
+ * @param map          The hashmap being iterated.
+ * @param cursor       The cursor, last moved to an entry by `apple_map_next`.
+ *
+ * @returns            `true` if the entry was removed.
+ *                     `false` if the cursor isn't at an entry or it was already removed.
+ *
+ * @version            0.3.0
+ */
+bool apple_map_cursor_remove(apple_map *map, apple_map_cursor *cursor)
+{
+  bucket *entry = cursor->entry;
+
+  if (!cursor->positioned || entry->key == NULL)
+  {
+    return false;
+  }
+
+  trace(map, APPLE_MAP_TRACE_REMOVE, entry->key, entry->key_size, entry->hash, 0);
+
+  /* A tombstone keeps its `next` link, so the cursor can still move past it. */
+  bury(map, entry);
+
+  return true;
+}
+
+/**
+ * @brief              Calls the `predicate` on every entry in insertion order and removes the
+ *                     entries it rejects, in a single pass. The predicate can also update the
+ *                     values of the entries it keeps. Once a quarter of the slots are taken by
+ *                     removed entries, the bucket array is rebuilt without them at the end.
+ *
+ * @param map          The hashmap to filter.
+ * @param predicate    The predicate, that decides whether an entry is kept. It must not change
+ *                     the hashmap.
+ * @param user         User pointer is a pointer that you can use in the `predicate`.
+ *
+ * @returns            The number of removed entries.
+ *
+ * @version            0.3.0
+ */
+size_t apple_map_retain(apple_map *map, apple_map_predicate predicate, void *user)
+{
+  size_t removed = 0;
+
+  for (bucket *current = map->first; current != NULL; current = current->next)
+  {
+    if (current->key == NULL || predicate(current->key, current->key_size, &current->value, user))
+    {
+      continue;
+    }
+
+    trace(map, APPLE_MAP_TRACE_REMOVE, current->key, current->key_size, current->hash, 0);
+    bury(map, current);
+
+    removed++;
+  }
+
+  if (map->tombstone_len > 0 && map->tombstone_len * 4 >= map->capacity)
+  {
+    rehash(map, map->capacity);
+  }
+
+  return removed;
+}
+
+#define PARALLEL_MAX_THREADS 64
+/* Ranges are never shorter than this, threads aren't worth starting for fewer slots. */
+#define PARALLEL_MIN_SLOTS 16384
+#define CACHE_LINE_SIZE 64
+
+struct slot_range
+{
+  apple_map *map;
+  size_t start, end;
+  uint32_t index;
+
+  void (*visit)(slot_range *range);
+  void *context;
+};
+
+typedef struct parallel_for_context
+{
+  apple_map_callback callback;
+  void *user;
+} parallel_for_context;
+
+typedef struct export_context
+{
+  const void **keys;
+  size_t *sizes;
+  uintptr_t *values;
+  size_t len;
+
+  /* Entries per range while counting, then the offset every range starts writing at. */
+  bool counting;
+  size_t offsets[PARALLEL_MAX_THREADS];
+} export_context;
+
+typedef struct parallel_reduce_context
+{
+  unsigned char *accumulators;
+  size_t stride;
+  apple_map_reduce_callback reduce;
+  void *user;
+} parallel_reduce_context;
+
+/**
+ * @brief              Calls the `callback` on every entry, splitting the bucket array into equal
+ *                     ranges of slots, that are visited by separate threads.
+ * @details            The callback runs concurrently and in no particular order, so it must be
+ *                     thread-safe. The hashmap must not change until the function returns. Small
+ *                     hashmaps are visited by fewer threads, down to the calling thread alone.
+ *
+ * @param map          The hashmap to iterate.
+ * @param threads_count The number of threads to use, up to 64. `0` is the same as `1`.
+ * @param callback     The callback, that will be called on each entry.
+ * @param user         User pointer is a pointer that you can use in the `callback`.
+ *
+ * @version            0.3.0
+ */
+void apple_map_parallel_for(apple_map *map, uint32_t threads_count, apple_map_callback callback,
+                            void *user)
+{
+  parallel_for_context context = {
+      .callback = callback,
+      .user = user,
+  };
+
+  slot_ranges_run(map, threads_count, parallel_for_range, &context);
+}
+
+/**
+ * @brief              Folds every entry into a result, using a private accumulator per thread,
+ *                     so threads never contend. Every accumulator starts as a copy of `identity`
+ *                     and the accumulators are merged into `out_result` in the order of the ranges
+ *                     they covered, once all threads finish.
+ *
+ * @param map          The hashmap to fold.
+ * @param threads_count The number of threads to use, up to 64. `0` is the same as `1`.
+ * @param accumulator_size The size of an accumulator.
+ * @param identity     The initial value of every accumulator.
+ * @param reduce       The callback, that folds an entry into an accumulator.
+ * @param combine      The callback, that merges an accumulator into the result.
+ * @param out_result   The accumulator to store the result in, `accumulator_size` bytes long.
+ * @param user         User pointer is a pointer that you can use in the callbacks.
+ *
+ * @returns            `true` if the entries were folded.
+ *                     `false` if accumulators of `accumulator_size` bytes can't even be sized, then
+ *                     `out_result` isn't touched.
+ *
+ * @version            0.3.0
+ */
+bool apple_map_parallel_reduce(apple_map *map, uint32_t threads_count, size_t accumulator_size,
+                               const void *identity, apple_map_reduce_callback reduce,
+                               apple_map_combine_callback combine, void *out_result, void *user)
+{
+  /* Threads beyond the number of ranges would only fold their identity into the result. */
+  threads_count = slot_ranges_len(map, threads_count);
+
+  if (accumulator_size > (SIZE_MAX - CACHE_LINE_SIZE) / PARALLEL_MAX_THREADS - CACHE_LINE_SIZE)
+  {
+    return false;
+  }
+
+  /* Accumulators sit on separate cache lines, so threads don't share lines while folding. */
+  size_t stride = (accumulator_size + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+  size_t size = stride * threads_count + CACHE_LINE_SIZE;
+  unsigned char *memory = NULL;
+  unsigned char *accumulators = NULL;
+
+  /* The allocator only aligns to `max_align_t`, so the block is aligned by hand. */
+  if (threads_count > 1 && stride > 0)
+  {
+    memory = map->allocator.alloc(map->allocator.context, size, _Alignof(max_align_t));
+  }
+
+  if (memory != NULL)
+  {
+    account((ptrdiff_t)size);
+    accumulators = memory + (CACHE_LINE_SIZE - (uintptr_t)memory % CACHE_LINE_SIZE) % CACHE_LINE_SIZE;
+  }
+
+  memcpy(out_result, identity, accumulator_size);
+
+  if (accumulators == NULL)
+  {
+    /* Fold everything straight into the result on the calling thread. */
+    parallel_reduce_context context = {
+        .accumulators = out_result,
+        .stride = 0,
+        .reduce = reduce,
+        .user = user,
+    };
+
+    slot_ranges_run(map, 1, parallel_reduce_range, &context);
+    return true;
+  }
+
+  for (uint32_t i = 0; i < threads_count; i++)
+  {
+    memcpy(accumulators + i * stride, identity, accumulator_size);
+  }
+
+  parallel_reduce_context context = {
+      .accumulators = accumulators,
+      .stride = stride,
+      .reduce = reduce,
+      .user = user,
+  };
+
+  slot_ranges_run(map, threads_count, parallel_reduce_range, &context);
+
+  for (uint32_t i = 0; i < threads_count; i++)
+  {
+    combine(out_result, accumulators + i * stride, user);
+  }
+
+  map->allocator.free(map->allocator.context, memory, size);
+  account(-(ptrdiff_t)size);
+
+  return true;
+}
+
+/**
+ * @brief              Copies the entries of the hashmap into caller arrays in one sequential scan
+ *                     of the bucket array, so the result is in slot order.
+ *
+ * @param map          The hashmap to export.
+ * @param keys_out     The array to store the keys in or `NULL` to skip them.
+ * @param sizes_out    The array to store the key sizes in or `NULL` to skip them.
+ * @param values_out   The array to store the values in or `NULL` to skip them.
+ * @param n            The length of the arrays. At most `n` entries are exported.
+ *
+ * @returns            The number of exported entries.
+ *
+ * @version            0.3.0
+ */
+size_t apple_map_export(apple_map *map, const void **keys_out, size_t *sizes_out,
+                        uintptr_t *values_out, size_t n)
+{
+  return apple_map_export_parallel(map, 1, keys_out, sizes_out, values_out, n);
+}
+
+/**
+ * @brief              Copies the values of the hashmap into a caller array, in slot order.
+ *
+ * @param map          The hashmap to export.
+ * @param values_out   The array to store the values in.
+ * @param n            The length of the array. At most `n` values are exported.
+ *
+ * @returns            The number of exported values.
+ *
+ * @version            0.3.0
+ */
+size_t apple_map_export_values(apple_map *map, uintptr_t *values_out, size_t n)
+{
+  return apple_map_export_parallel(map, 1, NULL, NULL, values_out, n);
+}
+
+/**
+ * @brief              Same as `apple_map_export`, but splits the bucket array into ranges of
+ *                     slots, that are exported by separate threads. The entries of every range
+ *                     are counted first, so each thread writes its own part of the arrays and
+ *                     the result is the same as that of `apple_map_export`.
+ *
+ * @param map          The hashmap to export. It must not change until the function returns.
+ * @param threads_count The number of threads to use, up to 64. `0` is the same as `1`.
+ * @param keys_out     The array to store the keys in or `NULL` to skip them.
+ * @param sizes_out    The array to store the key sizes in or `NULL` to skip them.
+ * @param values_out   The array to store the values in or `NULL` to skip them.
+ * @param n            The length of the arrays. At most `n` entries are exported.
+ *
+ * @returns            The number of exported entries.
+ *
+ * @version            0.3.0
+ */
+size_t apple_map_export_parallel(apple_map *map, uint32_t threads_count, const void **keys_out,
+                                 size_t *sizes_out, uintptr_t *values_out, size_t n)
+{
+  export_context context = {
+      .keys = keys_out,
+      .sizes = sizes_out,
+      .values = values_out,
+      .len = n,
+      .counting = true,
+  };
+
+  uint32_t ranges_len = slot_ranges_len(map, threads_count);
+
+  /* A single range starts at the beginning of the arrays, no need to count it. */
+  if (ranges_len > 1)
+  {
+    slot_ranges_run(map, ranges_len, export_range, &context);
+
+    size_t offset = 0;
+
+    for (uint32_t i = 0; i < ranges_len; i++)
+    {
+      size_t count = context.offsets[i];
+
+      context.offsets[i] = offset;
+      offset += count;
+    }
+  }
+
+  context.counting = false;
+  slot_ranges_run(map, ranges_len, export_range, &context);
+
+  size_t len = apple_map_len(map);
+
+  return len < n ? len : n;
+}
+
+static void slot_ranges_run(apple_map *map, uint32_t threads_count, void (*visit)(slot_range *range),
+                            void *context)
+{
+  pthread_t threads[PARALLEL_MAX_THREADS];
+  slot_range ranges[PARALLEL_MAX_THREADS];
+
+  threads_count = slot_ranges_len(map, threads_count);
+
+  size_t chunk = (map->capacity + threads_count - 1) / threads_count;
+  uint32_t started = 0;
+
+  for (uint32_t i = 0; i < threads_count; i++)
+  {
+    size_t start = i * chunk;
+
+    ranges[i].map = map;
+    ranges[i].start = start < map->capacity ? start : map->capacity;
+    ranges[i].end = map->capacity - ranges[i].start < chunk ? map->capacity : ranges[i].start + chunk;
+    ranges[i].index = i;
+    ranges[i].visit = visit;
+    ranges[i].context = context;
+  }
+
+  /* The first range is visited by the calling thread itself. */
+  for (uint32_t i = 1; i < threads_count; i++)
+  {
+    if (pthread_create(&threads[started], NULL, slot_range_thread, &ranges[i]) != 0)
+    {
+      visit(&ranges[i]);
+      continue;
+    }
+
+    started++;
+  }
+
+  visit(&ranges[0]);
+
+  for (uint32_t i = 0; i < started; i++)
+  {
+    pthread_join(threads[i], NULL);
+  }
+}
+
+static uint32_t slot_ranges_len(apple_map *map, uint32_t threads_count)
+{
+  size_t max_ranges = (map->capacity + PARALLEL_MIN_SLOTS - 1) / PARALLEL_MIN_SLOTS;
+
+  if (threads_count > PARALLEL_MAX_THREADS)
+  {
+    threads_count = PARALLEL_MAX_THREADS;
+  }
+
+  if (threads_count > max_ranges)
+  {
+    threads_count = (uint32_t)max_ranges;
+  }
+
+  return threads_count > 0 ? threads_count : 1;
+}
+
+static void *slot_range_thread(void *argument)
+{
+  slot_range *range = argument;
+
+  range->visit(range);
+
+  return NULL;
+}
+
+static void parallel_for_range(slot_range *range)
+{
+  parallel_for_context *context = range->context;
+
+  for (size_t i = range->start; i < range->end; i++)
+  {
+    bucket *entry = slot_at(range->map, i);
+
+    if (entry->key != NULL)
+      context->callback((void *)entry->key, entry->key_size, entry->value, context->user);
+  }
+}
+
+static void parallel_reduce_range(slot_range *range)
+{
+  parallel_reduce_context *context = range->context;
+  void *accumulator = context->accumulators + range->index * context->stride;
+
+  for (size_t i = range->start; i < range->end; i++)
+  {
+    bucket *entry = slot_at(range->map, i);
+
+    if (entry->key != NULL)
+      context->reduce(accumulator, entry->key, entry->key_size, entry->value, context->user);
+  }
+}
+
+static void export_range(slot_range *range)
+{
+  export_context *context = range->context;
+
+  if (context->counting)
+  {
+    size_t count = 0;
+
+    for (size_t i = range->start; i < range->end; i++)
+    {
+      count += slot_at(range->map, i)->key != NULL;
+    }
+
+    context->offsets[range->index] = count;
+    return;
+  }
+
+  size_t offset = context->offsets[range->index];
+
+  for (size_t i = range->start; i < range->end && offset < context->len; i++)
+  {
+    bucket *entry = slot_at(range->map, i);
+
+    if (entry->key == NULL)
+      continue;
+
+    if (context->keys != NULL)
+      context->keys[offset] = entry->key;
+
+    if (context->sizes != NULL)
+      context->sizes[offset] = entry->key_size;
+
+    if (context->values != NULL)
+      context->values[offset] = entry->value;
+
+    offset++;
+  }
+}
+
+
+#define ARENA_CHUNK_SIZE ((size_t)1 << 20)
+
+static void *arena_copy(apple_map *map, const void *key, size_t key_size)
+{
+  arena_chunk *chunk = map->arena;
+
+  if (chunk == NULL || chunk->capacity - chunk->used < key_size)
+  {
+    size_t capacity = key_size > ARENA_CHUNK_SIZE ? key_size : ARENA_CHUNK_SIZE;
+
+    chunk = map->allocator.alloc(map->allocator.context, sizeof(arena_chunk) + capacity,
+                                 _Alignof(arena_chunk));
+
+    if (chunk == NULL)
+    {
+      return NULL;
+    }
+
+    chunk->next = map->arena;
+    chunk->capacity = capacity;
+    chunk->used = 0;
+
+    map->arena = chunk;
+    map->arena_reserved += sizeof(arena_chunk) + capacity;
+
+    account(sizeof(arena_chunk) + capacity);
+  }
+
+  void *copy = chunk->data + chunk->used;
+
+  memcpy(copy, key, key_size);
+  chunk->used += key_size;
+
+  map->arena_used += key_size;
+
+  return copy;
+}
+
+static bool arena_compact(apple_map *map)
+{
+  size_t live = map->arena_used - map->arena_dead;
+  size_t capacity = live > ARENA_CHUNK_SIZE ? live : ARENA_CHUNK_SIZE;
+
+  arena_chunk *chunk = map->allocator.alloc(map->allocator.context, sizeof(arena_chunk) + capacity,
+                                            _Alignof(arena_chunk));
+
+  if (chunk == NULL)
+  {
+    return false;
+  }
+
+  chunk->next = NULL;
+  chunk->capacity = capacity;
+  chunk->used = 0;
+
+  /* The order list holds no tombstones right after a rehash. */
+  for (bucket *current = map->first; current != NULL; current = current->next)
+  {
+    unsigned char *copy = chunk->data + chunk->used;
+
+    memcpy(copy, current->key, current->key_size);
+    chunk->used += current->key_size;
+
+    current->key = copy;
+  }
+
+  arena_free(map, map->arena);
+
+  map->arena = chunk;
+  map->arena_reserved = sizeof(arena_chunk) + capacity;
+  map->arena_used = chunk->used;
+  map->arena_dead = 0;
+
+  account(map->arena_reserved);
+
+  return true;
+}
+
+static void arena_free(apple_map *map, arena_chunk *chunk)
+{
+  while (chunk != NULL)
+  {
+    arena_chunk *next = chunk->next;
+    size_t size = sizeof(arena_chunk) + chunk->capacity;
+
+    map->allocator.free(map->allocator.context, chunk, size);
+    map->arena_reserved -= size;
+
+    account(-(ptrdiff_t)size);
+
+    chunk = next;
+  }
+}
+
+#define STREAM_BUFFER_SIZE ((size_t)1 << 20)
+#define STREAM_BATCH_LEN 64
+
+typedef struct stream
+{
+  int fd;
+
+  unsigned char *buffer;
+  size_t capacity;
+  size_t start, end;
+
+  bool failed;
+} stream;
+
+typedef struct stream_record
+{
+  const void *key;
+  size_t key_size;
+  uint32_t hash;
+  uintptr_t value;
+} stream_record;
+
+static bool stream_fill(stream *input, size_t needed)
+{
+  if (input->end - input->start >= needed)
+  {
+    return true;
+  }
+
+  if (needed > input->capacity)
+  {
+    unsigned char *buffer = malloc(needed);
+
+    if (buffer == NULL)
+    {
+      input->failed = true;
+      return false;
+    }
+
+    memcpy(buffer, input->buffer + input->start, input->end - input->start);
+    free(input->buffer);
+
+    input->buffer = buffer;
+    input->capacity = needed;
+  }
+  else
+  {
+    memmove(input->buffer, input->buffer + input->start, input->end - input->start);
+  }
+
+  input->end -= input->start;
+  input->start = 0;
+
+  while (input->end < needed)
+  {
+    ssize_t got = read(input->fd, input->buffer + input->end, input->capacity - input->end);
+
+    if (got < 0)
+    {
+      input->failed = true;
+      return false;
+    }
+
+    if (got == 0)
+    {
+      return false;
+    }
+
+    input->end += got;
+  }
+
+  return true;
+}
+
+static void stream_flush(apple_map *map, stream_record *batch, size_t batch_len)
+{
+  reserve(map, batch_len);
+
+  /* The capacity is fixed for the whole batch now, so home slots can be fetched ahead. */
+  for (size_t i = 0; i < batch_len; i++)
+  {
+    PREFETCH(slot_at(map, batch[i].hash % map->capacity));
+  }
+
+  for (size_t i = 0; i < batch_len; i++)
+  {
+    trace(map, APPLE_MAP_TRACE_INSERT, batch[i].key, batch[i].key_size, batch[i].hash,
+          batch[i].value);
+
+    bool inserted;
+    bucket *entry = emplace(map, batch[i].key, batch[i].key_size, batch[i].hash, &inserted);
+
+    if (!inserted)
+    {
+      /* The existing entry keeps its key, so the copy of this one is garbage now. */
+      map->arena_dead += batch[i].key_size;
+    }
+
+    entry->value = batch[i].value;
+  }
+}
+
+/**
+ * @brief              Inserts the key-value records read from the file descriptor into the hashmap.
+ * @details            Keys are copied into memory owned by the hashmap, which is released by
+ *                     `apple_map_free`. The stream is read with large sequential reads and the
+ *                     records are inserted in batches. When the stream starts with a record count,
+ *                     the hashmap is grown once up front.
+ *
+ * @param map          The hashmap, into which the records will be inserted.
+ * @param fd           The file descriptor to read the records from.
+ * @param format       The layout of the records in the stream.
+ *
+ * @returns            `true` if the whole stream was loaded.
+ *                     `false` if reading failed, the stream ended in the middle of a record or
+ *                     the hashmap can't be grown to the record count the stream starts with.
+ *                     The records read before the failure stay in the hashmap.
+ *
+ * @version            0.3.0
+ */
+bool apple_map_load_stream(apple_map *map, int fd, apple_map_stream_format format)
+{
+  stream input = {
+      .fd = fd,
+      .buffer = malloc(STREAM_BUFFER_SIZE),
+      .capacity = STREAM_BUFFER_SIZE,
+  };
+
+  if (input.buffer == NULL)
+  {
+    return false;
+  }
+
+#ifdef POSIX_FADV_SEQUENTIAL
+  posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+  uint64_t remaining = UINT64_MAX;
+
+  if (format == APPLE_MAP_STREAM_COUNTED_RECORDS)
+  {
+    if (!stream_fill(&input, sizeof(uint64_t)))
+    {
+      free(input.buffer);
+      return false;
+    }
+
+    memcpy(&remaining, input.buffer + input.start, sizeof(uint64_t));
+    input.start += sizeof(uint64_t);
+
+    /* The count comes from the stream, so a count, that can't be reserved, rejects the stream. */
+    if (!reserve(map, remaining < SIZE_MAX ? (size_t)remaining : SIZE_MAX))
+    {
+      free(input.buffer);
+      return false;
+    }
+  }
+
+  stream_record batch[STREAM_BATCH_LEN];
+  size_t batch_len = 0;
+
+  bool loaded = true;
+
+  for (; remaining > 0; remaining--)
+  {
+    uint32_t key_size;
+
+    if (!stream_fill(&input, sizeof(uint32_t)))
+    {
+      /* A stream of records without a count may only end between two records. */
+      loaded = format == APPLE_MAP_STREAM_RECORDS && !input.failed &&
+               input.start == input.end;
+      break;
+    }
+
+    memcpy(&key_size, input.buffer + input.start, sizeof(uint32_t));
+
+    if (!stream_fill(&input, sizeof(uint32_t) + key_size + sizeof(uint64_t)))
+    {
+      loaded = false;
+      break;
+    }
+
+    const unsigned char *record = input.buffer + input.start + sizeof(uint32_t);
+    void *key = arena_copy(map, record, key_size);
+
+    if (key == NULL)
+    {
+      loaded = false;
+      break;
+    }
+
+    uint64_t value;
+    memcpy(&value, record + key_size, sizeof(uint64_t));
+
+    input.start += sizeof(uint32_t) + key_size + sizeof(uint64_t);
+
+    batch[batch_len].key = key;
+    batch[batch_len].key_size = key_size;
+    batch[batch_len].hash = hash_key(map, key, key_size);
+    batch[batch_len].value = (uintptr_t)value;
+
+    if (++batch_len == STREAM_BATCH_LEN)
+    {
+      stream_flush(map, batch, batch_len);
+      batch_len = 0;
+    }
+  }
+
+  stream_flush(map, batch, batch_len);
+  free(input.buffer);
+
+  return loaded;
+}
+
+#define TRACE_MAGIC 0x45435254454c5041ull /* "APLETRCE" */
+#define TRACE_VERSION 1u
+#define TRACE_BUFFER_SIZE ((size_t)64 << 10)
+/* Operation byte, two varints of up to 10 bytes, the hash and the key fingerprint. */
+#define TRACE_RECORD_MAX (1 + 10 + 4 + 10 + 8)
+#define TRACE_ID_SEED 0x9e3779b97f4a7c15ull
+
+struct trace_log
+{
+  int fd;
+  apple_map_trace_mode mode;
+
+  bool failed;
+
+  size_t used;
+  unsigned char buffer[TRACE_BUFFER_SIZE];
+};
+
+/**
+ * @brief              Starts logging every lookup, insertion, removal, reservation and clear made
+ *                     through the hashmap into `fd`, so the workload can be replayed offline.
+ * @details            The trace begins with the 64-bit magic `APLETRCE`, a 32-bit version and the
+ *                     32-bit `mode`. Each record that follows is the operation byte, the key size as
+ *                     a LEB128 varint, the 32-bit hash of the key, the value as a LEB128 varint and
+ *                     then either the key bytes or its 64-bit fingerprint. Fixed-size fields use the
+ *                     byte order of the machine. Records are buffered, so the file is complete only
+ *                     after `apple_map_trace_stop` or `apple_map_free`.
+ *
+ * @param map          The hashmap to trace.
+ * @param fd           The descriptor to write into. It isn't closed by the hashmap.
+ * @param mode         Whether the key bytes or their fingerprints are recorded.
+ *
+ * @returns            `true` if tracing started.
+ *                     `false` if the hashmap is already traced or the trace couldn't be set up.
+ *
+ * @version            0.3.0
+ */
+bool apple_map_trace_start(apple_map *map, int fd, apple_map_trace_mode mode)
+{
+  if (map->trace != NULL)
+  {
+    return false;
+  }
+
+  trace_log *log = map->allocator.alloc(map->allocator.context, sizeof(trace_log), _Alignof(trace_log));
+
+  if (log == NULL)
+  {
+    return false;
+  }
+
+  uint64_t magic = TRACE_MAGIC;
+  uint32_t header[2] = {TRACE_VERSION, (uint32_t)mode};
+
+  log->fd = fd;
+  log->mode = mode;
+  log->failed = false;
+  log->used = 0;
+
+  trace_write(log, &magic, sizeof(magic));
+  trace_write(log, header, sizeof(header));
+
+  if (!trace_flush(log))
+  {
+    map->allocator.free(map->allocator.context, log, sizeof(trace_log));
+    return false;
+  }
+
+  account(sizeof(trace_log));
+
+  map->trace = log;
+
+  return true;
+}
+
+/**
+ * @brief              Flushes the trace of the hashmap and stops tracing it.
+ * @param map          The traced hashmap.
+ *
+ * @returns            `true` if every record was written successfully.
+ *                     `false` if a write failed or the hashmap wasn't traced.
+ *
+ * @version            0.3.0
+ */
+bool apple_map_trace_stop(apple_map *map)
+{
+  trace_log *log = map->trace;
+
+  if (log == NULL)
+  {
+    return false;
+  }
+
+  bool written = trace_flush(log);
+
+  map->trace = NULL;
+  map->allocator.free(map->allocator.context, log, sizeof(trace_log));
+
+  account(-(ptrdiff_t)sizeof(trace_log));
+
+  return written;
+}
+
+static size_t trace_size(const apple_map *map)
+{
+  return map->trace != NULL ? sizeof(trace_log) : 0;
+}
+
+static inline void trace(apple_map *map, apple_map_trace_op op, const void *key, size_t key_size,
+                         uint32_t hash, uint64_t value)
+{
+  if (map->trace != NULL)
+  {
+    trace_append(map->trace, op, key, key_size, hash, value);
+  }
+}
+
+static void trace_append(trace_log *log, apple_map_trace_op op, const void *key, size_t key_size,
+                         uint32_t hash, uint64_t value)
+{
+  unsigned char record[TRACE_RECORD_MAX];
+  size_t size = 0;
+  uint64_t key_size_left = key_size;
+
+  record[size++] = (unsigned char)op;
+
+  do
+  {
+    record[size++] = (unsigned char)(key_size_left & 0x7f) | (key_size_left > 0x7f ? 0x80 : 0);
+    key_size_left >>= 7;
+  } while (key_size_left > 0);
+
+  memcpy(&record[size], &hash, sizeof(hash));
+  size += sizeof(hash);
+
+  do
+  {
+    record[size++] = (unsigned char)(value & 0x7f) | (value > 0x7f ? 0x80 : 0);
+    value >>= 7;
+  } while (value > 0);
+
+  if (op == APPLE_MAP_TRACE_RESERVE || op == APPLE_MAP_TRACE_CLEAR)
+  {
+    trace_write(log, record, size);
+  }
+  else if (log->mode == APPLE_MAP_TRACE_KEY_IDS)
+  {
+    uint64_t id = fnv_1a_hash_seeded(key, key_size, TRACE_ID_SEED);
+
+    memcpy(&record[size], &id, sizeof(id));
+    trace_write(log, record, size + sizeof(id));
+  }
+  else
+  {
+    trace_write(log, record, size);
+    trace_write(log, key, key_size);
+  }
+}
+
+static void trace_write(trace_log *log, const void *data, size_t size)
+{
+  if (log->used + size > TRACE_BUFFER_SIZE)
+  {
+    trace_flush(log);
+  }
+
+  if (size > TRACE_BUFFER_SIZE)
+  {
+    log->failed |= !write_all(log->fd, data, size);
+    return;
+  }
+
+  memcpy(&log->buffer[log->used], data, size);
+  log->used += size;
+}
+
+static bool trace_flush(trace_log *log)
+{
+  log->failed |= !write_all(log->fd, log->buffer, log->used);
+  log->used = 0;
+
+  return !log->failed;
+}
+
+static bool write_all(int fd, const void *data, size_t size)
+{
+  const unsigned char *bytes = data;
+
+  while (size > 0)
+  {
+    ssize_t written = write(fd, bytes, size);
+
+    if (written < 0)
+    {
+      if (errno == EINTR)
+        continue;
+
+      return false;
+    }
+
+    bytes += written;
+    size -= written;
+  }
+
+  return true;
+}
+
+#define FROZEN_MAGIC 0x4e5a5246454c5041ull /* "APLEFRZN" */
+#define FROZEN_VERSION 1u
+
+/* Average count of keys sharing one displacement. */
+#define FROZEN_BUCKET_LOAD 4
+
+#define FROZEN_MAX_ATTEMPTS 8
+
+typedef struct frozen_header
+{
+  uint64_t magic;
+  uint32_t version;
+  uint32_t reserved;
+
+  uint64_t salt;
+  uint64_t len;
+  uint64_t displacements_len;
+
+  uint64_t displacements_offset;
+  uint64_t entries_offset;
+  uint64_t keys_offset;
+  uint64_t image_size;
+} frozen_header;
+
+typedef struct frozen_entry
+{
+  uint64_t key_offset;
+  uint64_t key_size;
+  uint64_t value;
+} frozen_entry;
+
+/**
+ * @brief      Frozen hashmap is an immutable snapshot of a hashmap, backed by a minimal perfect
+ *             hash. The whole table is a single position-independent image: a header, the
+ *             displacement table, the slot array and the blob of keys, referenced by offsets.
+ *
+ * @version    0.3.0
+ */
+struct apple_frozen_map
+{
+  unsigned char *image;
+  size_t image_size;
+  bool mapped;
+
+  const frozen_header *header;
+  const uint32_t *displacements;
+  const frozen_entry *entries;
+  const unsigned char *keys;
+};
+
+typedef struct frozen_key
+{
+  uint64_t hash;
+  uint64_t displacement_index;
+  bucket *entry;
+} frozen_key;
+
+/**
+ * @brief              Builds a frozen hashmap out of the entries of the hashmap.
+ * @details            Keys are copied into the frozen hashmap, so the source hashmap and its keys
+ *                     can be freed afterwards. The source hashmap is not modified.
+ *
+ * @param map          The hashmap to freeze.
+ *
+ * @returns            A newly allocated frozen hashmap or `NULL` if the allocation failed, no
+ *                     displacements that place every key into its own slot were found within the
+ *                     limited number of hash seeds tried, or the hashmap was created with a
+ *                     `value_size` larger than `sizeof(uintptr_t)`, since frozen hashmaps hold
+ *                     `uintptr_t` values only.
+ *
+ * @version            0.3.0
+ */
+apple_frozen_map *apple_map_freeze(apple_map *map)
+{
+  if (map->value_size > sizeof(uintptr_t))
+  {
+    return NULL;
+  }
+
+  apple_frozen_map *frozen = malloc(sizeof(apple_frozen_map));
+
+  if (frozen == NULL)
+  {
+    return NULL;
+  }
+
+  for (uint64_t salt = 0; salt < FROZEN_MAX_ATTEMPTS; salt++)
+  {
+    if (frozen_build(frozen, map, 2166136261u + salt))
+    {
+      return frozen;
+    }
+  }
+
+  free(frozen);
+  return NULL;
+}
+
+static inline uint64_t frozen_mix(uint64_t hash)
+{
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccd;
+  hash ^= hash >> 33;
+  hash *= 0xc4ceb9fe1a85ec53;
+  hash ^= hash >> 33;
+
+  return hash;
+}
+
+static inline uint64_t frozen_slot(uint64_t hash, uint32_t displacement, uint64_t len)
+{
+  return frozen_mix(hash ^ ((uint64_t)displacement + 1) * 0x9e3779b97f4a7c15) % len;
+}
+
+static bool frozen_build(apple_frozen_map *frozen, apple_map *map, uint64_t salt)
+{
+  uint64_t len = apple_map_len(map);
+  uint64_t displacements_len = len / FROZEN_BUCKET_LOAD + 1;
+
+  uint64_t keys_size = 0;
+
+  for (bucket *current = map->first; current != NULL; current = current->next)
+  {
+    if (current->key != NULL)
+      keys_size += current->key_size;
+  }
+
+  uint64_t displacements_offset = sizeof(frozen_header);
+  uint64_t entries_offset = (displacements_offset + displacements_len * sizeof(uint32_t) + 7) & ~(uint64_t)7;
+  uint64_t keys_offset = entries_offset + len * sizeof(frozen_entry);
+  uint64_t image_size = keys_offset + keys_size;
+
+  unsigned char *image = calloc(1, image_size);
+  frozen_key *keys = malloc((len + 1) * sizeof(frozen_key));
+  uint64_t *starts = calloc(displacements_len + 1, sizeof(uint64_t));
+  uint64_t *order = malloc(displacements_len * sizeof(uint64_t));
+  uint64_t *slots = malloc((FROZEN_BUCKET_LOAD * 16 + 1) * sizeof(uint64_t));
+  unsigned char *taken = calloc(len + 1, 1);
+
+  bool built = false;
+
+  if (image == NULL || keys == NULL || starts == NULL ||
+      order == NULL || slots == NULL || taken == NULL)
+  {
+    goto cleanup;
+  }
+
+  /* Group the keys by displacement, using a counting sort. */
+  size_t count = 0;
+
+  for (bucket *current = map->first; current != NULL; current = current->next)
+  {
+    if (current->key == NULL)
+      continue;
+
+    uint64_t hash = fnv_1a_hash_seeded(current->key, current->key_size, salt);
+
+    keys[count].hash = hash;
+    keys[count].displacement_index = frozen_mix(hash) % displacements_len;
+    keys[count].entry = current;
+
+    starts[keys[count].displacement_index + 1]++;
+    count++;
+  }
+
+  uint64_t max_group = 0;
+
+  for (uint64_t i = 0; i < displacements_len; i++)
+  {
+    if (starts[i + 1] > max_group)
+      max_group = starts[i + 1];
+
+    starts[i + 1] += starts[i];
+  }
+
+  if (max_group > FROZEN_BUCKET_LOAD * 16)
+  {
+    goto cleanup;
+  }
+
+  frozen_key *grouped = malloc((len + 1) * sizeof(frozen_key));
+
+  if (grouped == NULL)
+  {
+    goto cleanup;
+  }
+
+  uint64_t *fill = order;
+  memcpy(fill, starts, displacements_len * sizeof(uint64_t));
+
+  for (size_t i = 0; i < count; i++)
+  {
+    grouped[fill[keys[i].displacement_index]++] = keys[i];
+  }
+
+  free(keys);
+  keys = grouped;
+
+  /* Place the largest groups first, while the slot array is still mostly free. */
+  uint64_t *by_size = calloc(max_group + 2, sizeof(uint64_t));
+
+  if (by_size == NULL)
+  {
+    goto cleanup;
+  }
+
+  for (uint64_t i = 0; i < displacements_len; i++)
+  {
+    by_size[max_group - (starts[i + 1] - starts[i]) + 1]++;
+  }
+
+  for (uint64_t i = 0; i <= max_group; i++)
+  {
+    by_size[i + 1] += by_size[i];
+  }
+
+  for (uint64_t i = 0; i < displacements_len; i++)
+  {
+    order[by_size[max_group - (starts[i + 1] - starts[i])]++] = i;
+  }
+
+  free(by_size);
+
+  frozen_header *header = (frozen_header *)image;
+  uint32_t *displacements = (uint32_t *)(image + displacements_offset);
+  frozen_entry *entries = (frozen_entry *)(image + entries_offset);
+
+  for (uint64_t i = 0; i < displacements_len; i++)
+  {
+    uint64_t group = order[i];
+    uint64_t group_start = starts[group];
+    uint64_t group_len = starts[group + 1] - group_start;
+
+    if (group_len == 0)
+    {
+      break;
+    }
+
+    uint32_t displacement = 0;
+
+    while (true)
+    {
+      uint64_t placed = 0;
+
+      for (; placed < group_len; placed++)
+      {
+        uint64_t slot = frozen_slot(keys[group_start + placed].hash, displacement, len);
+
+        if (taken[slot])
+          break;
+
+        taken[slot] = 1;
+        slots[placed] = slot;
+      }
+
+      if (placed == group_len)
+      {
+        break;
+      }
+
+      for (uint64_t j = 0; j < placed; j++)
+      {
+        taken[slots[j]] = 0;
+      }
+
+      if (++displacement == UINT32_MAX)
+      {
+        goto cleanup;
+      }
+    }
+
+    displacements[group] = displacement;
+
+    for (uint64_t j = 0; j < group_len; j++)
+    {
+      entries[slots[j]].key_offset = (uint64_t)(uintptr_t)keys[group_start + j].entry;
+    }
+  }
+
+  /* Lay the keys out in slot order, so neighbouring slots have neighbouring keys. */
+  uint64_t key_offset = keys_offset;
+
+  for (uint64_t i = 0; i < len; i++)
+  {
+    bucket *entry = (bucket *)(uintptr_t)entries[i].key_offset;
+
+    memcpy(image + key_offset, entry->key, entry->key_size);
+
+    entries[i].key_offset = key_offset;
+    entries[i].key_size = entry->key_size;
+    entries[i].value = entry->value;
+
+    key_offset += entry->key_size;
+  }
+
+  header->magic = FROZEN_MAGIC;
+  header->version = FROZEN_VERSION;
+  header->salt = salt;
+  header->len = len;
+  header->displacements_len = displacements_len;
+  header->displacements_offset = displacements_offset;
+  header->entries_offset = entries_offset;
+  header->keys_offset = keys_offset;
+  header->image_size = image_size;
+
+  frozen->image = image;
+  frozen->image_size = image_size;
+  frozen->mapped = false;
+  frozen->header = header;
+  frozen->displacements = displacements;
+  frozen->entries = entries;
+  frozen->keys = image;
+
+  image = NULL;
+  built = true;
+
+cleanup:
+  free(image);
+  free(keys);
+  free(starts);
+  free(order);
+  free(slots);
+  free(taken);
+
+  return built;
+}
+
+/**
+ * @brief              Resolves a key-value pair from the frozen hashmap.
+ *
+ * @param map          The frozen hashmap, from which the key-value pair will be resolved.
+ * @param key          The key to resolve.
+ * @param key_size     The size of the key.
+ * @param out_value    The reference to a value to store the resolved value.
+ *
+ * @returns            `true` if the key exists in the frozen hashmap.
+ *                     `false` otherwise.
+ *
+ * @version            0.3.0
+ */
+bool apple_frozen_map_get(apple_frozen_map *map, const void *key, size_t key_size, uintptr_t *out_value)
+{
+  uint64_t len = map->header->len;
+
+  if (len == 0 || key_size > map->image_size)
+  {
+    return false;
+  }
+
+  uint64_t hash = fnv_1a_hash_seeded(key, key_size, map->header->salt);
+  uint32_t displacement = map->displacements[frozen_mix(hash) % map->header->displacements_len];
+
+  const frozen_entry *entry = &map->entries[frozen_slot(hash, displacement, len)];
+
+  if (entry->key_size != key_size ||
+      entry->key_offset > map->image_size - key_size ||
+      memcmp(map->keys + entry->key_offset, key, key_size) != 0)
+  {
+    return false;
+  }
+
+  *out_value = (uintptr_t)entry->value;
+
+  return true;
+}
+
+/**
+ * @brief            Returns the number of entries in the frozen hashmap.
+ * @returns          The number of entries in the frozen hashmap.
+ *
+ * @version          0.3.0
+ */
+size_t apple_frozen_map_len(apple_frozen_map *map)
+{
+  return map->header->len;
+}
+
+/**
+ * @brief              Iterates through the frozen hashmap in slot order, using the `callback`.
+ * @details            Entries of a corrupted file, whose keys lie outside of it, are skipped, as
+ *                     `apple_frozen_map_get` never finds them either.
+ * @param map          The frozen hashmap to iterate.
+ * @param callback     The callback, that will be called on each entry.
+ * @param user         User pointer is a pointer that you can use in the `callback`.
+ *
+ * @version            0.3.0
+ */
+void apple_frozen_map_iter(apple_frozen_map *map, apple_map_callback callback, void *user)
+{
+  for (uint64_t i = 0; i < map->header->len; i++)
+  {
+    const frozen_entry *entry = &map->entries[i];
+
+    /* Mapped files aren't trusted, so keys are bounds-checked here like in lookups. */
+    if (entry->key_size > map->image_size || entry->key_offset > map->image_size - entry->key_size)
+      continue;
+
+    callback((void *)(map->keys + entry->key_offset), entry->key_size, (uintptr_t)entry->value, user);
+  }
+}
+
+/**
+ * @brief              Frees the frozen hashmap object together with the copied keys, or unmaps
+ *                     it if it was opened with `apple_map_open_mmap`.
+ * @param map          The frozen hashmap object to free.
+ *
+ * @version            0.3.0
+ */
+void apple_frozen_map_free(apple_frozen_map *map)
+{
+  if (map->mapped)
+  {
+    munmap(map->image, map->image_size);
+  }
+  else
+  {
+    free(map->image);
+  }
+
+  free(map);
+}
+
+/**
+ * @brief              Writes a frozen snapshot of the hashmap into a file, that can later be
+ *                     opened with `apple_map_open_mmap`.
+ * @details            The file stores offsets instead of pointers, so it doesn't depend on the
+ *                     address it is mapped at. It uses the byte order of the machine that wrote it.
+ *                     An existing file is replaced like in `apple_frozen_map_save`.
+ *
+ * @param map          The hashmap to save.
+ * @param path         The path of the file to create or replace.
+ *
+ * @returns            `true` if the file was written successfully.
+ *                     `false` otherwise, also when the hashmap can't be frozen, for example
+ *                     because its `value_size` is larger than `sizeof(uintptr_t)`.
+ *
+ * @version            0.3.0
+ */
+bool apple_map_save(apple_map *map, const char *path)
+{
+  apple_frozen_map *frozen = apple_map_freeze(map);
+
+  if (frozen == NULL)
+  {
+    return false;
+  }
+
+  bool saved = apple_frozen_map_save(frozen, path);
+
+  apple_frozen_map_free(frozen);
+
+  return saved;
+}
+
+/**
+ * @brief              Writes the frozen hashmap into a file, that can later be opened with
+ *                     `apple_map_open_mmap`.
+ * @details            The image is written into `path` with a `.tmp` suffix, synced and then
+ *                     renamed over `path`, so processes, that have the previous file mapped,
+ *                     keep reading it intact, and new ones map either the old or the new file.
+ *
+ * @param map          The frozen hashmap to save.
+ * @param path         The path of the file to create or replace.
+ *
+ * @returns            `true` if the file was written successfully.
+ *                     `false` otherwise.
+ *
+ * @version            0.3.0
+ */
+bool apple_frozen_map_save(apple_frozen_map *map, const char *path)
+{
+  size_t path_len = strlen(path);
+  char *temporary = malloc(path_len + sizeof(".tmp"));
+
+  if (temporary == NULL)
+  {
+    return false;
+  }
+
+  memcpy(temporary, path, path_len);
+  memcpy(temporary + path_len, ".tmp", sizeof(".tmp"));
+
+  /* Truncating the target itself would fault the processes, that have it mapped. */
+  int fd = open(temporary, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+  if (fd < 0)
+  {
+    free(temporary);
+    return false;
+  }
+
+  bool written = write_all(fd, map->image, map->image_size) && fsync(fd) == 0;
+
+  written = close(fd) == 0 && written;
+  written = written && rename(temporary, path) == 0;
+
+  if (!written)
+  {
+    unlink(temporary);
+  }
+
+  free(temporary);
+
+  return written;
+}
+
+/**
+ * @brief              Maps a file written by `apple_map_save` into memory and serves lookups
+ *                     directly from the mapping, without deserializing it.
+ * @details            The mapping is read-only and shared, so processes opening the same file share
+ *                     its pages. Use `apple_frozen_map_free` to unmap it.
+ *
+ * @param path         The path of the file to map.
+ *
+ * @returns            The frozen hashmap backed by the mapping or `NULL` if the file can't be
+ *                     opened or isn't a valid hashmap image.
+ *
+ * @version            0.3.0
+ */
+apple_frozen_map *apple_map_open_mmap(const char *path)
+{
+  int fd = open(path, O_RDONLY);
+
+  if (fd < 0)
+  {
+    return NULL;
+  }
+
+  struct stat info;
+
+  if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(frozen_header))
+  {
+    close(fd);
+    return NULL;
+  }
+
+  size_t image_size = info.st_size;
+  unsigned char *image = mmap(NULL, image_size, PROT_READ, MAP_SHARED, fd, 0);
+
+  close(fd);
+
+  if (image == MAP_FAILED)
+  {
+    return NULL;
+  }
+
+  apple_frozen_map *frozen = malloc(sizeof(apple_frozen_map));
+
+  if (frozen == NULL || !frozen_validate(image, image_size))
+  {
+    free(frozen);
+    munmap(image, image_size);
+    return NULL;
+  }
+
+  const frozen_header *header = (const frozen_header *)image;
+
+  frozen->image = image;
+  frozen->image_size = image_size;
+  frozen->mapped = true;
+  frozen->header = header;
+  frozen->displacements = (const uint32_t *)(image + header->displacements_offset);
+  frozen->entries = (const frozen_entry *)(image + header->entries_offset);
+  frozen->keys = image;
+
+  return frozen;
+}
+
+static bool frozen_validate(const unsigned char *image, size_t image_size)
+{
+  const frozen_header *header = (const frozen_header *)image;
+
+  if (header->magic != FROZEN_MAGIC ||
+      header->version != FROZEN_VERSION ||
+      header->image_size != image_size ||
+      header->displacements_len == 0)
+  {
+    return false;
+  }
+
+  /* Compare through divisions, so huge counts in a corrupted header can't overflow. */
+  if (header->displacements_offset < sizeof(frozen_header) ||
+      header->displacements_offset % sizeof(uint32_t) != 0 ||
+      header->entries_offset < header->displacements_offset ||
+      header->entries_offset % sizeof(uint64_t) != 0 ||
+      (header->entries_offset - header->displacements_offset) / sizeof(uint32_t) < header->displacements_len ||
+      header->keys_offset < header->entries_offset ||
+      header->keys_offset > image_size ||
+      (header->keys_offset - header->entries_offset) / sizeof(frozen_entry) < header->len)
+  {
+    return false;
+  }
+
+  return true;
 }
\ No newline at end of file
@@ -2,7 +2,7 @@
  * @author    Adi Salimgereyev
  * @brief      C library, that implements a hashmap using FNV-1a hashing algorithm.
  * @date      8/17/2023
- * @version   0.2.0
+ * @version   0.3.0
  */
 
 #ifndef _APPLE_MAP_H_
@@ -32,6 +32,394 @@ typedef struct apple_map apple_map;
  */
 typedef void (*apple_map_callback)(void *key, size_t key_size, uintptr_t value, void *user);
 
+/**
+ * @brief            Predicate type for deciding which entries `apple_map_retain` keeps.
+ *
+ * @param key        Current entry key.
+ * @param key_size   Current entry key size.
+ * @param value      The value of the current entry, that can be updated in place.
+ * @param user       User pointer is a pointer that you can pass through `apple_map_retain`.
+ *
+ * @returns          `true` to keep the entry.
+ *                   `false` to remove it.
+ *
+ * @version          0.3.0
+ */
+typedef bool (*apple_map_predicate)(const void *key, size_t key_size, uintptr_t *value, void *user);
+
+/**
+ * @brief              Callback type for resolving a key present in both hashmaps passed to
+ *                     `apple_map_merge`.
+ *
+ * @param key          The key present in both hashmaps.
+ * @param key_size     The size of the key.
+ * @param value        The value in the hashmap merged into.
+ * @param other_value  The value in the merged hashmap.
+ * @param user         User pointer is a pointer that you can pass through `apple_map_merge`.
+ *
+ * @returns            The value to keep.
+ *
+ * @version            0.3.0
+ */
+typedef uintptr_t (*apple_map_conflict_callback)(const void *key, size_t key_size, uintptr_t value,
+                                                 uintptr_t other_value, void *user);
+
+/**
+ * @brief              Callback type for resolving a key present in both hashmaps passed to
+ *                     `apple_map_merge_values`, by updating the value in place.
+ *
+ * @param key          The key present in both hashmaps.
+ * @param key_size     The size of the key.
+ * @param value        The value in the hashmap merged into, to update.
+ * @param other_value  The value in the merged hashmap.
+ * @param user         User pointer is a pointer that you can pass through `apple_map_merge_values`.
+ *
+ * @version            0.3.0
+ */
+typedef void (*apple_map_value_conflict_callback)(const void *key, size_t key_size, void *value,
+                                                  const void *other_value, void *user);
+
+/**
+ * @brief              Callback type for folding an entry into the accumulator of the thread, that
+ *                     visits it in `apple_map_parallel_reduce`.
+ *
+ * @param accumulator  The accumulator of the current thread.
+ * @param key          Current entry key.
+ * @param key_size     Current entry key size.
+ * @param value        Current entry value.
+ * @param user         User pointer is a pointer that you can pass through `apple_map_parallel_reduce`.
+ *
+ * @version            0.3.0
+ */
+typedef void (*apple_map_reduce_callback)(void *accumulator, const void *key, size_t key_size,
+                                          uintptr_t value, void *user);
+
+/**
+ * @brief              Callback type for merging the accumulator of a thread into the result of
+ *                     `apple_map_parallel_reduce`.
+ *
+ * @param accumulator  The result to merge into.
+ * @param other        The accumulator of a finished thread.
+ * @param user         User pointer is a pointer that you can pass through `apple_map_parallel_reduce`.
+ *
+ * @version            0.3.0
+ */
+typedef void (*apple_map_combine_callback)(void *accumulator, const void *other, void *user);
+
+/**
+ * @brief      Order in which a cursor visits the entries of a hashmap.
+ *
+ * @version    0.3.0
+ */
+typedef enum apple_map_cursor_order
+{
+  /** The order in which the entries were inserted, the same as `apple_map_iter`. */
+  APPLE_MAP_INSERTION_ORDER,
+  /** The order of the slots in the bucket array, which reads it sequentially. */
+  APPLE_MAP_SLOT_ORDER,
+} apple_map_cursor_order;
+
+/**
+ * @brief      Position of a pull-style iteration through a hashmap, advanced by `apple_map_next`.
+ *             Its fields are private. A zero-initialized cursor starts in insertion order.
+ *
+ * @version    0.3.0
+ */
+typedef struct apple_map_cursor
+{
+  apple_map_cursor_order order;
+  void *entry;
+  size_t index;
+  bool positioned;
+} apple_map_cursor;
+
+/**
+ * @brief      Memory used by a hashmap, reported by `apple_map_memory_usage`.
+ *
+ * @version    0.3.0
+ */
+typedef struct apple_map_memory_report
+{
+  /** Bytes reserved for the bucket array. */
+  size_t buckets_bytes;
+  /** Bytes reserved for keys copied by the hashmap. */
+  size_t keys_bytes;
+  /** Part of `keys_bytes` taken by the keys of live entries. */
+  size_t keys_live_bytes;
+  /** Bytes of the hashmap object itself. */
+  size_t metadata_bytes;
+  /** Bytes of the buffer of a running trace, started by `apple_map_trace_start`. */
+  size_t trace_bytes;
+  /** Sum of `buckets_bytes`, `keys_bytes`, `metadata_bytes` and `trace_bytes`. */
+  size_t total_bytes;
+  /** `total_bytes` divided by the number of live entries, or `0` for an empty hashmap. */
+  double bytes_per_entry;
+} apple_map_memory_report;
+
+/**
+ * @brief      Number of bins in the histograms of `apple_map_stats_report`.
+ *
+ * @version    0.3.0
+ */
+#define APPLE_MAP_STATS_HISTOGRAM_LEN 16
+
+/**
+ * @brief      Occupancy and probing statistics of a hashmap, computed by `apple_map_stats`.
+ * @details    A probe length is the number of slots examined by a lookup, including the slot
+ *             that ends it. Miss probe lengths are averaged over every possible home slot.
+ *
+ * @version    0.3.0
+ */
+typedef struct apple_map_stats_report
+{
+  /** Number of slots in the bucket array. */
+  size_t capacity;
+  /** Number of live entries. */
+  size_t len;
+  /** Number of slots taken by removed entries, that still lengthen probes. */
+  size_t tombstones;
+  /** Share of slots taken by live entries and tombstones. */
+  double load_factor;
+
+  /** Average probe length of a successful lookup. */
+  double average_hit_probe;
+  /** Longest probe length of a successful lookup. */
+  size_t max_hit_probe;
+  /** Average probe length of an unsuccessful lookup. */
+  double average_miss_probe;
+  /** Longest probe length of an unsuccessful lookup. */
+  size_t max_miss_probe;
+
+  /**
+   * Number of live entries by probe length: bin `i` counts lookups examining `i + 1` slots, the
+   * last bin also counts all longer probes.
+   */
+  size_t probe_histogram[APPLE_MAP_STATS_HISTOGRAM_LEN];
+  /**
+   * Number of clusters (runs of taken slots) by size: bin `i` counts clusters of
+   * `2^i` to `2^(i+1) - 1` slots, the last bin also counts all larger clusters.
+   */
+  size_t cluster_histogram[APPLE_MAP_STATS_HISTOGRAM_LEN];
+  /** Size of the largest cluster. */
+  size_t max_cluster;
+} apple_map_stats_report;
+
+#ifdef APPLE_MAP_COUNTERS
+/**
+ * @brief      Hot path counters of a hashmap, read by `apple_map_read_counters`.
+ * @details    Counters are only compiled in when both the library and its users are built with
+ *             `APPLE_MAP_COUNTERS` defined. Without it they cost nothing.
+ *
+ * @version    0.3.0
+ */
+typedef struct apple_map_counters
+{
+  /** Number of keys hashed. */
+  uint64_t hashes;
+  /** Number of slots examined by lookups. */
+  uint64_t probes;
+  /** Number of key comparisons with `memcmp`. */
+  uint64_t compares;
+  /** Number of slots skipped because the cached hash didn't match. */
+  uint64_t hash_rejects;
+  /** Number of times the bucket array was rebuilt. */
+  uint64_t resizes;
+  /** Time spent rebuilding the bucket array, in nanoseconds. */
+  uint64_t resize_ns;
+} apple_map_counters;
+#endif
+
+/**
+ * @brief            Hook type for tracking memory of all hashmaps in the process.
+ *
+ * @param delta      Number of bytes allocated, negative if the bytes were freed.
+ * @param user       User pointer is a pointer that you can pass through `apple_map_set_memory_hook`.
+ *
+ * @version          0.3.0
+ */
+typedef void (*apple_map_memory_hook)(ptrdiff_t delta, void *user);
+
+/**
+ * @brief      Moment of a resize, reported by `apple_map_resize_event`.
+ *
+ * @version    0.3.0
+ */
+typedef enum apple_map_resize_phase
+{
+  /** The bucket array is about to be rebuilt. */
+  APPLE_MAP_RESIZE_BEFORE,
+  /** The bucket array was rebuilt, or its allocation failed and it was left untouched. */
+  APPLE_MAP_RESIZE_AFTER,
+} apple_map_resize_phase;
+
+/**
+ * @brief      Description of a rebuild of the bucket array, passed into `apple_map_resize_hook`.
+ *             A rebuild with equal old and new capacity only drops tombstones.
+ *
+ * @version    0.3.0
+ */
+typedef struct apple_map_resize_event
+{
+  apple_map_resize_phase phase;
+
+  /** Capacity before the rebuild. */
+  size_t old_capacity;
+  /** Capacity after the rebuild. Equals `old_capacity` if the allocation failed. */
+  size_t new_capacity;
+  /** Number of live entries at the start of the rebuild. */
+  size_t len;
+  /** Number of tombstones dropped by the rebuild. */
+  size_t tombstones;
+
+  /** Number of entries moved into the new bucket array. Only set after the rebuild. */
+  size_t entries_moved;
+  /** `true` if the owned keys were compacted too. Only set after the rebuild. */
+  bool keys_compacted;
+  /** Time the rebuild took, in nanoseconds. Only set after the rebuild. */
+  uint64_t elapsed_ns;
+} apple_map_resize_event;
+
+/**
+ * @brief            Hook type for observing rebuilds of the bucket array.
+ *
+ * @param map        The hashmap being rebuilt. It must not be modified inside the hook.
+ * @param event      The description of the rebuild.
+ * @param user       User pointer is a pointer that you can pass through `apple_map_set_resize_hook`.
+ *
+ * @version          0.3.0
+ */
+typedef void (*apple_map_resize_hook)(apple_map *map, const apple_map_resize_event *event, void *user);
+
+/**
+ * @brief      Layout of the records read by `apple_map_load_stream`. Every record is a 32-bit
+ *             key size, the key bytes and a 64-bit value, all in the byte order of the machine.
+ *
+ * @version    0.3.0
+ */
+typedef enum apple_map_stream_format
+{
+  /** Records follow one another until the end of the stream. */
+  APPLE_MAP_STREAM_RECORDS,
+  /** A 64-bit record count comes first, followed by exactly that many records. */
+  APPLE_MAP_STREAM_COUNTED_RECORDS,
+} apple_map_stream_format;
+
+/**
+ * @brief      Operations logged by a trace started with `apple_map_trace_start`.
+ *
+ * @version    0.3.0
+ */
+typedef enum apple_map_trace_op
+{
+  /** `apple_map_get`. */
+  APPLE_MAP_TRACE_GET = 1,
+  /** `apple_map_insert` and `apple_map_soft_insert`, the value is the inserted one. */
+  APPLE_MAP_TRACE_INSERT = 2,
+  /** `apple_map_get_or_insert`, the value is the one inserted if the key is absent. */
+  APPLE_MAP_TRACE_GET_OR_INSERT = 3,
+  /** `apple_map_entry`. */
+  APPLE_MAP_TRACE_ENTRY = 4,
+  /** `apple_map_remove` and `apple_map_remove_free`. */
+  APPLE_MAP_TRACE_REMOVE = 5,
+  /** `apple_map_reserve`, the value is the number of additional entries. Carries no key. */
+  APPLE_MAP_TRACE_RESERVE = 6,
+  /** `apple_map_clear`. Carries no key. */
+  APPLE_MAP_TRACE_CLEAR = 7,
+} apple_map_trace_op;
+
+/**
+ * @brief      How a trace records keys.
+ *
+ * @version    0.3.0
+ */
+typedef enum apple_map_trace_mode
+{
+  /** Every record carries the key bytes. */
+  APPLE_MAP_TRACE_KEYS,
+  /**
+   * Every record carries a 64-bit fingerprint of the key instead of its bytes, so traces of
+   * sensitive or large keys stay small and anonymous, while still telling keys apart.
+   */
+  APPLE_MAP_TRACE_KEY_IDS,
+} apple_map_trace_mode;
+
+/**
+ * @brief      Flags, that change the behaviour of a hashmap created with
+ *             `apple_map_new_with_config`.
+ *
+ * @version    0.3.0
+ */
+typedef enum apple_map_flags
+{
+  /**
+   * The hashmap copies every inserted key into memory it owns, so callers don't have to keep
+   * keys alive. The copies are bump-allocated in large chunks, released together by
+   * `apple_map_free` and compacted when the hashmap is resized. Callbacks receive the owned
+   * copies, which must not be freed.
+   */
+  APPLE_MAP_OWN_KEYS = 1 << 0,
+  /**
+   * Bucket arrays of 2 MiB and more are mapped directly with `mmap` and backed by 2 MiB pages,
+   * which cuts TLB misses of random probes in very large hashmaps. Explicit huge pages are used
+   * when the system has reserved them, transparent huge pages requested with `madvise` otherwise.
+   * Such arrays bypass the allocator of the hashmap.
+   */
+  APPLE_MAP_HUGE_PAGES = 1 << 1,
+} apple_map_flags;
+
+/**
+ * @brief      Allocator used by a hashmap for its header, bucket array and owned keys.
+ * @details    Every allocation is freed through `free` of the same allocator, with the size it
+ *             was requested with. Allocations never need an alignment larger than
+ *             `_Alignof(max_align_t)`.
+ *
+ * @version    0.3.0
+ */
+typedef struct apple_map_allocator
+{
+  /** Allocates `size` bytes aligned to `alignment`. Returns `NULL` on failure. */
+  void *(*alloc)(void *context, size_t size, size_t alignment);
+  /** Same as `alloc`, but the returned memory is filled with zeros. */
+  void *(*zeroed_alloc)(void *context, size_t size, size_t alignment);
+  /** Frees `size` bytes allocated by `alloc` or `zeroed_alloc`. */
+  void (*free)(void *context, void *pointer, size_t size);
+  /** Context pointer passed into every callback. */
+  void *context;
+} apple_map_allocator;
+
+/**
+ * @brief      Configuration of a hashmap created with `apple_map_new_with_config`.
+ *             A zero-initialized configuration describes the default hashmap.
+ *
+ * @version    0.3.0
+ */
+typedef struct apple_map_config
+{
+  /** Combination of `apple_map_flags`. */
+  uint32_t flags;
+  /**
+   * Allocator of the hashmap, copied into it. `NULL` selects `malloc`, `calloc` and `free`, with
+   * bucket arrays of 2 MiB and more mapped directly with `mmap`. Fresh mappings are already
+   * zero, so growing the hashmap doesn't zero-fill the new array and its pages are faulted in
+   * only when the rehash writes them.
+   */
+  const apple_map_allocator *allocator;
+  /**
+   * Number of threads, that fault in the pages of every new mapped bucket array before it is
+   * filled, up to 64. `0` leaves the pages to be faulted lazily by the rehash itself.
+   */
+  uint32_t prefault_threads;
+  /**
+   * Size of the values, that are stored inline in the slots, so values such as small structs
+   * need neither a separate allocation nor a pointer chase. They are accessed through
+   * `apple_map_get_ptr`, `apple_map_insert_value` and `apple_map_entry_ptr` and aligned to 8
+   * bytes. Every slot grows by the size rounded up to 8 bytes, so it suits values of a few dozen
+   * bytes. Functions that take or pass `uintptr_t` values see the first `sizeof(uintptr_t)` bytes
+   * of an inline value. `0` selects `uintptr_t` values. Sets ignore it.
+   */
+  size_t value_size;
+} apple_map_config;
+
 /**
  * @brief      Creates a new empty hashmap.
  * @returns    A newly allocated empty hashmap.
@@ -40,9 +428,20 @@ typedef void (*apple_map_callback)(void *key, size_t key_size, uintptr_t value,
  */
 apple_map *apple_map_new(void);
 
+/**
+ * @brief              Creates a new empty hashmap, configured by `config`.
+ * @param config       The configuration of the hashmap. `NULL` or a zero-initialized
+ *                     configuration give the same hashmap as `apple_map_new`.
+ * @returns            A newly allocated empty hashmap.
+ *
+ * @version            0.3.0
+ */
+apple_map *apple_map_new_with_config(const apple_map_config *config);
+
 /**
  * @brief            Inserts a key-value pair into the hashmap.
- * @details          Function doesn't copy a key, so you should guarantee its lifetime.
+ * @details          Function doesn't copy a key, unless the hashmap was created with
+ *                   `APPLE_MAP_OWN_KEYS`, so you should guarantee its lifetime.
  *
  * @param map        The hashmap, into which the key-value pair will be inserted.
  * @param key        The key, to insert into the hashmap.
@@ -79,12 +478,86 @@ bool apple_map_get(apple_map *map, const void *key, size_t key_size, uintptr_t *
  *                     value that will be set to the value of successfully resolved entry.
  *
  * @returns            `true` if the key-value pair already exists.
- *                     `false` otherwise.
+ *                     `false` otherwise. The new entry was inserted then, unless the hashmap was
+ *                     created with `APPLE_MAP_OWN_KEYS` and the key couldn't be copied, which
+ *                     leaves the key absent.
  *
  * @version            0.1.0
  */
 bool apple_map_get_or_insert(apple_map *map, const void *key, size_t key_size, uintptr_t *out_in);
 
+/**
+ * @brief              Resolves the value slot of a key, inserting a new entry with a zero value
+ *                     when the key is absent. The returned pointer can be used to read and update
+ *                     the value in place, without hashing and probing the key a second time.
+ * @details            The pointer stays valid until the next call that mutates the hashmap.
+ *                     Function doesn't copy a key, unless the hashmap was created with
+ *                     `APPLE_MAP_OWN_KEYS`, so you should guarantee its lifetime.
+ *
+ * @param map          The hashmap, in which the key will be resolved or inserted.
+ * @param key          The key to resolve.
+ * @param key_size     The size of the key.
+ * @param out_inserted The reference to a flag, that is set to `true` if a new entry was inserted
+ *                     and to `false` if the entry already existed or couldn't be inserted. Can be
+ *                     `NULL`.
+ *
+ * @returns            The pointer to the value of the entry or `NULL` if the key couldn't be copied.
+ *
+ * @version            0.3.0
+ */
+uintptr_t *apple_map_entry(apple_map *map, const void *key, size_t key_size, bool *out_inserted);
+
+/**
+ * @brief              Resolves the value of a key in place.
+ * @details            The pointer stays valid until the next call that mutates the hashmap.
+ *
+ * @param map          The hashmap, from which the value will be resolved.
+ * @param key          The key to resolve.
+ * @param key_size     The size of the key.
+ *
+ * @returns            The pointer to the `value_size` bytes of the value, stored inline in the
+ *                     slot, or `NULL` if the hashmap doesn't have the key.
+ *
+ * @version            0.3.0
+ */
+void *apple_map_get_ptr(apple_map *map, const void *key, size_t key_size);
+
+/**
+ * @brief            Inserts a key-value pair into the hashmap, copying the `value_size` bytes of
+ *                   the value into the slot.
+ * @details          Function doesn't copy a key, unless the hashmap was created with
+ *                   `APPLE_MAP_OWN_KEYS`, so you should guarantee its lifetime.
+ *
+ * @param map        The hashmap, into which the key-value pair will be inserted.
+ * @param key        The key, to insert into the hashmap.
+ * @param key_size   The size of the key.
+ * @param value      The value to copy.
+ *
+ * @returns          `true` if the key-value pair was stored.
+ *                   `false` if the key couldn't be copied.
+ *
+ * @version          0.3.0
+ */
+bool apple_map_insert_value(apple_map *map, const void *key, size_t key_size, const void *value);
+
+/**
+ * @brief              Same as `apple_map_entry`, but the returned pointer addresses the whole
+ *                     value stored inline in the slot. Values of new entries are zeroed.
+ *
+ * @param map          The hashmap, in which the key will be resolved or inserted.
+ * @param key          The key to resolve.
+ * @param key_size     The size of the key.
+ * @param out_inserted The reference to a flag, that is set to `true` if a new entry was inserted
+ *                     and to `false` if the entry already existed or couldn't be inserted. Can be
+ *                     `NULL`.
+ *
+ * @returns            The pointer to the `value_size` bytes of the value or `NULL` if the key
+ *                     couldn't be copied.
+ *
+ * @version            0.3.0
+ */
+void *apple_map_entry_ptr(apple_map *map, const void *key, size_t key_size, bool *out_inserted);
+
 /**
  * @brief              Similiar to `apple_map_insert`, but when trying to overwrite a hashmap entry,
  *                     it will free the old entry's data via callback using `callback`.
@@ -132,6 +605,59 @@ void apple_map_remove_free(apple_map *map, const void *key, size_t key_size,
  */
 size_t apple_map_len(apple_map *map);
 
+/**
+ * @brief              Reports the memory used by the hashmap.
+ * @param map          The hashmap to inspect.
+ * @param out_report   The reference to a report to fill.
+ *
+ * @version            0.3.0
+ */
+void apple_map_memory_usage(apple_map *map, apple_map_memory_report *out_report);
+
+/**
+ * @brief              Installs a process-wide hook, that is called every time any hashmap
+ *                     allocates or frees memory, with the change in bytes.
+ * @details            The hook is global and isn't synchronized, so install it before
+ *                     hashmaps are created on other threads. Memory allocated before the hook
+ *                     was installed is not reported, but freeing it is, so a running total of
+ *                     the deltas is only correct if the hook is installed before any hashmap is
+ *                     created.
+ * @param hook         The hook to call or `NULL` to remove it.
+ * @param user         User pointer is a pointer that you can use in the `hook`.
+ *
+ * @version            0.3.0
+ */
+void apple_map_set_memory_hook(apple_map_memory_hook hook, void *user);
+
+/**
+ * @brief              Computes occupancy and probing statistics of the hashmap by scanning its
+ *                     whole bucket array.
+ * @param map          The hashmap to inspect.
+ * @param out_stats    The reference to a report to fill.
+ *
+ * @version            0.3.0
+ */
+void apple_map_stats(apple_map *map, apple_map_stats_report *out_stats);
+
+#ifdef APPLE_MAP_COUNTERS
+/**
+ * @brief              Reads the hot path counters of the hashmap.
+ * @param map          The hashmap to inspect.
+ * @param out_counters The reference to counters to fill.
+ *
+ * @version            0.3.0
+ */
+void apple_map_read_counters(apple_map *map, apple_map_counters *out_counters);
+
+/**
+ * @brief              Sets all hot path counters of the hashmap to zero.
+ * @param map          The hashmap, which counters will be reset.
+ *
+ * @version            0.3.0
+ */
+void apple_map_reset_counters(apple_map *map);
+#endif
+
 /**
  * @brief              Resizes the hashmap to a new capacity when the hashmap is full.
  * @param map          The hashmap to iterate.
@@ -140,8 +666,88 @@ size_t apple_map_len(apple_map *map);
  */
 void apple_map_resize(apple_map *map);
 
+/**
+ * @brief              Grows the hashmap once, so that `additional` more entries can be inserted
+ *                     without resizing it again.
+ * @param map          The hashmap to grow.
+ * @param additional   The number of entries, that are about to be inserted.
+ *
+ * @returns            `true` if the hashmap can take the entries without resizing.
+ *                     `false` if a bucket array for that many entries can't be sized or allocated.
+ *                     The hashmap is left as it was then.
+ *
+ * @version            0.3.0
+ */
+bool apple_map_reserve(apple_map *map, size_t additional);
+
+/**
+ * @brief              Inserts the key-value records read from the file descriptor into the hashmap.
+ * @details            Keys are copied into memory owned by the hashmap, which is released by
+ *                     `apple_map_free`. The stream is read with large sequential reads and the
+ *                     records are inserted in batches. When the stream starts with a record count,
+ *                     the hashmap is grown once up front.
+ *
+ * @param map          The hashmap, into which the records will be inserted.
+ * @param fd           The file descriptor to read the records from.
+ * @param format       The layout of the records in the stream.
+ *
+ * @returns            `true` if the whole stream was loaded.
+ *                     `false` if reading failed, the stream ended in the middle of a record or
+ *                     the hashmap can't be grown to the record count the stream starts with.
+ *                     The records read before the failure stay in the hashmap.
+ *
+ * @version            0.3.0
+ */
+bool apple_map_load_stream(apple_map *map, int fd, apple_map_stream_format format);
+
+/**
+ * @brief              Installs a hook, that is called right before and right after the bucket
+ *                     array of the hashmap is rebuilt, either to grow it or to drop tombstones.
+ * @param map          The hashmap to observe.
+ * @param hook         The hook to call or `NULL` to remove it.
+ * @param user         User pointer is a pointer that you can use in the `hook`.
+ *
+ * @version            0.3.0
+ */
+void apple_map_set_resize_hook(apple_map *map, apple_map_resize_hook hook, void *user);
+
+/**
+ * @brief              Starts logging every lookup, insertion, removal, reservation and clear made
+ *                     through the hashmap into `fd`, so the workload can be replayed offline.
+ * @details            The trace begins with the 64-bit magic `APLETRCE`, a 32-bit version and the
+ *                     32-bit `mode`. Each record that follows is the operation byte, the key size as
+ *                     a LEB128 varint, the 32-bit hash of the key, the value as a LEB128 varint and
+ *                     then either the key bytes or its 64-bit fingerprint. Fixed-size fields use the
+ *                     byte order of the machine. Records are buffered, so the file is complete only
+ *                     after `apple_map_trace_stop` or `apple_map_free`.
+ *
+ * @param map          The hashmap to trace.
+ * @param fd           The descriptor to write into. It isn't closed by the hashmap.
+ * @param mode         Whether the key bytes or their fingerprints are recorded.
+ *
+ * @returns            `true` if tracing started.
+ *                     `false` if the hashmap is already traced or the trace couldn't be set up.
+ *
+ * @version            0.3.0
+ */
+bool apple_map_trace_start(apple_map *map, int fd, apple_map_trace_mode mode);
+
+/**
+ * @brief              Flushes the trace of the hashmap and stops tracing it.
+ * @param map          The traced hashmap.
+ *
+ * @returns            `true` if every record was written successfully.
+ *                     `false` if a write failed or the hashmap wasn't traced.
+ *
+ * @version            0.3.0
+ */
+bool apple_map_trace_stop(apple_map *map);
+
 /**
  * @brief              Iterates through the hashmap, using the `callback`.
+ * @details            The callback may remove the entry it was called with, but nothing else may
+ *                     change the hashmap during the iteration, since a resize would free the
+ *                     entries being walked. Use `apple_map_retain` to filter entries.
  * @param map          The hashmap to iterate.
  * @param callback     The callback, that will be called on each entry.
  * @param user         User pointer is a pointer that you can use in the `callback`.
@@ -150,14 +756,557 @@ void apple_map_resize(apple_map *map);
  */
 void apple_map_iter(apple_map *map, apple_map_callback callback, void *user);
 
+/**
+ * @brief              Positions the cursor before the first entry of any hashmap.
+ * @param cursor       The cursor to initialize.
+ * @param order        The order, in which the cursor visits the entries.
+ *
+ * @version            0.3.0
+ */
+void apple_map_cursor_init(apple_map_cursor *cursor, apple_map_cursor_order order);
+
+/**
+ * @brief              Advances the cursor to the next entry of the hashmap.
+ * @details            Unlike `apple_map_iter`, the caller drives the iteration, so it can stop at
+ *                     any entry and walk several hashmaps in lockstep. Stopping early needs no
+ *                     cleanup. Entries removed before the cursor reaches them are skipped. Anything
+ *                     that resizes the hashmap, an insertion included, invalidates the cursor.
+ *
+ * @param map          The hashmap to iterate.
+ * @param cursor       The cursor, initialized by `apple_map_cursor_init`.
+ * @param out_key      The reference to store the key of the entry in. Can be `NULL`.
+ * @param out_key_size The reference to store the key size of the entry in. Can be `NULL`.
+ * @param out_value    The reference to store the value of the entry in. Can be `NULL`.
+ *
+ * @returns            `true` if the cursor moved to an entry.
+ *                     `false` if there are no more entries.
+ *
+ * @version            0.3.0
+ */
+bool apple_map_next(apple_map *map, apple_map_cursor *cursor, const void **out_key,
+                    size_t *out_key_size, uintptr_t *out_value);
+
+/**
+ * @brief              Removes the entry the cursor is at, without hashing or probing its key.
+ *                     The cursor stays valid and `apple_map_next` moves on to the following entry.
+ *
+ * @param map          The hashmap being iterated.
+ * @param cursor       The cursor, last moved to an entry by `apple_map_next`.
+ *
+ * @returns            `true` if the entry was removed.
+ *                     `false` if the cursor isn't at an entry or it was already removed.
+ *
+ * @version            0.3.0
+ */
+bool apple_map_cursor_remove(apple_map *map, apple_map_cursor *cursor);
+
+/**
+ * @brief              Calls the `predicate` on every entry in insertion order and removes the
+ *                     entries it rejects, in a single pass. The predicate can also update the
+ *                     values of the entries it keeps. Once a quarter of the slots are taken by
+ *                     removed entries, the bucket array is rebuilt without them at the end.
+ *
+ * @param map          The hashmap to filter.
+ * @param predicate    The predicate, that decides whether an entry is kept. It must not change
+ *                     the hashmap.
+ * @param user         User pointer is a pointer that you can use in the `predicate`.
+ *
+ * @returns            The number of removed entries.
+ *
+ * @version            0.3.0
+ */
+size_t apple_map_retain(apple_map *map, apple_map_predicate predicate, void *user);
+
+/**
+ * @brief              Calls the `callback` on every entry, splitting the bucket array into equal
+ *                     ranges of slots, that are visited by separate threads.
+ * @details            The callback runs concurrently and in no particular order, so it must be
+ *                     thread-safe. The hashmap must not change until the function returns. Small
+ *                     hashmaps are visited by fewer threads, down to the calling thread alone.
+ *
+ * @param map          The hashmap to iterate.
+ * @param threads_count The number of threads to use, up to 64. `0` is the same as `1`.
+ * @param callback     The callback, that will be called on each entry.
+ * @param user         User pointer is a pointer that you can use in the `callback`.
+ *
+ * @version            0.3.0
+ */
+void apple_map_parallel_for(apple_map *map, uint32_t threads_count, apple_map_callback callback,
+                            void *user);
+
+/**
+ * @brief              Folds every entry into a result, using a private accumulator per thread,
+ *                     so threads never contend. Every accumulator starts as a copy of `identity`
+ *                     and the accumulators are merged into `out_result` in the order of the ranges
+ *                     they covered, once all threads finish.
+ *
+ * @param map          The hashmap to fold.
+ * @param threads_count The number of threads to use, up to 64. `0` is the same as `1`.
+ * @param accumulator_size The size of an accumulator.
+ * @param identity     The initial value of every accumulator.
+ * @param reduce       The callback, that folds an entry into an accumulator.
+ * @param combine      The callback, that merges an accumulator into the result.
+ * @param out_result   The accumulator to store the result in, `accumulator_size` bytes long.
+ * @param user         User pointer is a pointer that you can use in the callbacks.
+ *
+ * @returns            `true` if the entries were folded.
+ *                     `false` if accumulators of `accumulator_size` bytes can't even be sized, then
+ *                     `out_result` isn't touched.
+ *
+ * @version            0.3.0
+ */
+bool apple_map_parallel_reduce(apple_map *map, uint32_t threads_count, size_t accumulator_size,
+                               const void *identity, apple_map_reduce_callback reduce,
+                               apple_map_combine_callback combine, void *out_result, void *user);
+
+/**
+ * @brief              Copies the entries of the hashmap into caller arrays in one sequential scan
+ *                     of the bucket array, so the result is in slot order.
+ *
+ * @param map          The hashmap to export.
+ * @param keys_out     The array to store the keys in or `NULL` to skip them.
+ * @param sizes_out    The array to store the key sizes in or `NULL` to skip them.
+ * @param values_out   The array to store the values in or `NULL` to skip them.
+ * @param n            The length of the arrays. At most `n` entries are exported.
+ *
+ * @returns            The number of exported entries.
+ *
+ * @version            0.3.0
+ */
+size_t apple_map_export(apple_map *map, const void **keys_out, size_t *sizes_out,
+                        uintptr_t *values_out, size_t n);
+
+/**
+ * @brief              Copies the values of the hashmap into a caller array, in slot order.
+ *
+ * @param map          The hashmap to export.
+ * @param values_out   The array to store the values in.
+ * @param n            The length of the array. At most `n` values are exported.
+ *
+ * @returns            The number of exported values.
+ *
+ * @version            0.3.0
+ */
+size_t apple_map_export_values(apple_map *map, uintptr_t *values_out, size_t n);
+
+/**
+ * @brief              Same as `apple_map_export`, but splits the bucket array into ranges of
+ *                     slots, that are exported by separate threads. The entries of every range
+ *                     are counted first, so each thread writes its own part of the arrays and
+ *                     the result is the same as that of `apple_map_export`.
+ *
+ * @param map          The hashmap to export. It must not change until the function returns.
+ * @param threads_count The number of threads to use, up to 64. `0` is the same as `1`.
+ * @param keys_out     The array to store the keys in or `NULL` to skip them.
+ * @param sizes_out    The array to store the key sizes in or `NULL` to skip them.
+ * @param values_out   The array to store the values in or `NULL` to skip them.
+ * @param n            The length of the arrays. At most `n` entries are exported.
+ *
+ * @returns            The number of exported entries.
+ *
+ * @version            0.3.0
+ */
+size_t apple_map_export_parallel(apple_map *map, uint32_t threads_count, const void **keys_out,
+                                 size_t *sizes_out, uintptr_t *values_out, size_t n);
+
+/**
+ * @brief              Removes every entry from the hashmap, but keeps its capacity, so it can be
+ *                     refilled without growing it again.
+ * @details            Only the slots that were ever filled are reset when they are a small share of
+ *                     the bucket array, so clearing a sparse hashmap costs as much as its entries.
+ *                     Otherwise the whole array is zeroed, a mapped one by dropping its pages. Keys
+ *                     copied by the hashmap are released, but their memory is kept for new keys.
+ *                     Like `apple_map_free`, it doesn't free the key-value pairs themselves.
+ * @param map          The hashmap to clear.
+ *
+ * @version            0.3.0
+ */
+void apple_map_clear(apple_map *map);
+
+/**
+ * @brief              Creates a copy of the hashmap with the same configuration, capacity and
+ *                     insertion order, by copying its bucket array slot by slot and relocating the
+ *                     order links, without hashing or probing a single key.
+ * @details            Keys are shared with the original, unless it owns them or holds some of them
+ *                     in its own memory, like the keys read by `apple_map_load_stream`, then the
+ *                     copy owns copies of them. Hooks and traces aren't copied.
+ * @param map          The hashmap to copy.
+ *
+ * @returns            The copy or `NULL` if the memory for it couldn't be allocated.
+ *
+ * @version            0.3.0
+ */
+apple_map *apple_map_clone(apple_map *map);
+
+/**
+ * @brief              Inserts every entry of `source` into the hashmap, reusing the hashes
+ *                     cached in `source`. The hashmap is grown once up front and the home slots of
+ *                     every batch of entries are fetched ahead of inserting them.
+ * @details            Keys are shared with `source`, unless the hashmap was created with
+ *                     `APPLE_MAP_OWN_KEYS` or `source` holds some of its keys in its own memory,
+ *                     like the keys read by `apple_map_load_stream`, then they are copied.
+ *                     Otherwise you should guarantee their lifetime.
+ *
+ * @param map          The hashmap to merge into.
+ * @param source       The hashmap to merge from. It isn't changed.
+ * @param conflict     The callback, that picks the value of a key present in both hashmaps, or
+ *                     `NULL` to take the value from `source`. Values stored inline, that are larger
+ *                     than `uintptr_t`, can't be picked by it, merge such hashmaps with
+ *                     `apple_map_merge_values`.
+ * @param user         User pointer is a pointer that you can use in the `conflict` callback.
+ *
+ * @returns            `true` if every entry was merged.
+ *                     `false` if a key couldn't be copied, the values of the two hashmaps differ
+ *                     in size or `conflict` was given for values larger than `uintptr_t`, which
+ *                     leaves the hashmap unchanged.
+ *
+ * @version            0.3.0
+ */
+bool apple_map_merge(apple_map *map, apple_map *source, apple_map_conflict_callback conflict,
+                     void *user);
+
+/**
+ * @brief              Same as `apple_map_merge`, but a key present in both hashmaps is resolved by
+ *                     updating its value in place, so whole values stored inline can be combined,
+ *                     like the aggregation states of two partial results.
+ *
+ * @param map          The hashmap to merge into.
+ * @param source       The hashmap to merge from. It isn't changed.
+ * @param conflict     The callback, that updates the value of a key present in both hashmaps, or
+ *                     `NULL` to take the value from `source`.
+ * @param user         User pointer is a pointer that you can use in the `conflict` callback.
+ *
+ * @returns            `true` if every entry was merged.
+ *                     `false` if a key couldn't be copied or the values of the two hashmaps differ
+ *                     in size.
+ *
+ * @version            0.3.0
+ */
+bool apple_map_merge_values(apple_map *map, apple_map *source,
+                            apple_map_value_conflict_callback conflict, void *user);
+
+/**
+ * @brief              Creates a hashmap of the entries of `map`, whose keys are also in `other`.
+ * @details            The smaller of the two hashmaps is walked and its cached hashes are looked
+ *                     up in the other one in batches, with the home slots fetched ahead. The new
+ *                     hashmap is configured like `map` and its keys are shared with `map`, unless
+ *                     it owns them or `map` holds them in its own memory.
+ *
+ * @param map          The hashmap, whose entries are kept.
+ * @param other        The hashmap, whose keys select the entries.
+ *
+ * @returns            The new hashmap or `NULL` if the memory for it couldn't be allocated.
+ *
+ * @version            0.3.0
+ */
+apple_map *apple_map_intersect(apple_map *map, apple_map *other);
+
+/**
+ * @brief              Creates a hashmap of the entries of `map`, whose keys aren't in `other`.
+ * @details            `map` is walked and its cached hashes are looked up in `other` in batches,
+ *                     with the home slots fetched ahead. The new hashmap is configured like `map`
+ *                     and its keys are shared with `map`, unless it owns them or `map` holds them
+ *                     in its own memory.
+ *
+ * @param map          The hashmap, whose entries are kept.
+ * @param other        The hashmap, whose keys are excluded.
+ *
+ * @returns            The new hashmap or `NULL` if the memory for it couldn't be allocated.
+ *
+ * @version            0.3.0
+ */
+apple_map *apple_map_difference(apple_map *map, apple_map *other);
+
+/**
+ * @brief              Creates a hashmap of the entries of both hashmaps. Keys present in both keep
+ *                     the value from `map`.
+ * @details            The larger of the two hashmaps is cloned and the smaller one is merged into
+ *                     the clone, reusing its cached hashes, so the order of the entries follows the
+ *                     larger hashmap. The new hashmap is configured like `map` and its keys are
+ *                     shared with the inputs, unless it owns them.
+ *
+ * @param map          The first hashmap, whose values win.
+ * @param other        The second hashmap.
+ *
+ * @returns            The new hashmap or `NULL` if the memory for it couldn't be allocated or the
+ *                     values of the two hashmaps differ in size.
+ *
+ * @version            0.3.0
+ */
+apple_map *apple_map_union(apple_map *map, apple_map *other);
+
 /**
  * @brief              Frees the hashmap object and inner buckets.
  * @details            This function doesn't free the key-value pairs. You can achieve that by
- *                     using `apple_map_iter` with callback freeing the hashmap entries.
+ *                     using `apple_map_iter` with callback freeing the hashmap entries. Keys
+ *                     copied by the hashmap itself are freed here. A running trace is flushed.
  * @param map          The hashmap object to free.
  *
  * @version            0.1.0
  */
 void apple_map_free(apple_map *map);
 
+/**
+ * @brief      Set is a hashmap without values. It is built on the same table as the hashmap,
+ *             but its slots have no room for a value, which makes them a fifth smaller, so more
+ *             of them fit into every cache line.
+ *
+ * @version    0.3.0
+ */
+typedef struct apple_set apple_set;
+
+/**
+ * @brief      Creates a new empty set.
+ * @returns    A newly allocated empty set.
+ *
+ * @version    0.3.0
+ */
+apple_set *apple_set_new(void);
+
+/**
+ * @brief              Creates a new empty set, configured by `config` like a hashmap.
+ * @param config       The configuration of the set. `NULL` or a zero-initialized configuration
+ *                     give the same set as `apple_set_new`.
+ * @returns            A newly allocated empty set.
+ *
+ * @version            0.3.0
+ */
+apple_set *apple_set_new_with_config(const apple_map_config *config);
+
+/**
+ * @brief            Inserts a key into the set.
+ * @details          Function doesn't copy a key, unless the set was created with
+ *                   `APPLE_MAP_OWN_KEYS`, so you should guarantee its lifetime.
+ *
+ * @param set        The set, into which the key will be inserted.
+ * @param key        The key, to insert into the set.
+ * @param key_size   The size of the key.
+ *
+ * @returns          `true` if the key was inserted.
+ *                   `false` if the set already had it.
+ *
+ * @version          0.3.0
+ */
+bool apple_set_insert(apple_set *set, const void *key, size_t key_size);
+
+/**
+ * @brief              Inserts `n` keys into the set. The set is grown once up front, the keys are
+ *                     hashed in batches and the home slots of a batch are fetched ahead of
+ *                     probing them, so cache misses overlap instead of following each other.
+ *
+ * @param set          The set, into which the keys will be inserted.
+ * @param keys         The keys to insert.
+ * @param sizes        The sizes of the keys.
+ * @param n            The number of keys.
+ *
+ * @returns            The number of keys, that weren't in the set yet.
+ *
+ * @version            0.3.0
+ */
+size_t apple_set_insert_many(apple_set *set, const void *const *keys, const size_t *sizes, size_t n);
+
+/**
+ * @brief            Checks whether the set has the key.
+ *
+ * @param set        The set to search.
+ * @param key        The key to search for.
+ * @param key_size   The size of the key.
+ *
+ * @returns          `true` if the set has the key.
+ *
+ * @version          0.3.0
+ */
+bool apple_set_contains(apple_set *set, const void *key, size_t key_size);
+
+/**
+ * @brief              Checks which of `n` keys the set has, hashing them in batches and fetching
+ *                     the home slots of a batch ahead of probing them.
+ *
+ * @param set          The set to search.
+ * @param keys         The keys to search for.
+ * @param sizes        The sizes of the keys.
+ * @param n            The number of keys.
+ * @param out_found    The array of `n` flags to store whether each key was found. Can be `NULL`.
+ *
+ * @returns            The number of keys found.
+ *
+ * @version            0.3.0
+ */
+size_t apple_set_contains_many(apple_set *set, const void *const *keys, const size_t *sizes, size_t n,
+                               bool *out_found);
+
+/**
+ * @brief            Removes a key from the set.
+ *
+ * @param set        The set, from which the key will be removed.
+ * @param key        The key to remove.
+ * @param key_size   The size of the key.
+ *
+ * @returns          `true` if the key was removed.
+ *                   `false` if the set didn't have it.
+ *
+ * @version          0.3.0
+ */
+bool apple_set_remove(apple_set *set, const void *key, size_t key_size);
+
+/**
+ * @brief      Returns the number of keys in the set.
+ *
+ * @version    0.3.0
+ */
+size_t apple_set_len(apple_set *set);
+
+/**
+ * @brief              Advances the cursor to the next key of the set, like `apple_map_next`.
+ *
+ * @param set          The set to iterate.
+ * @param cursor       The cursor, initialized by `apple_map_cursor_init`.
+ * @param out_key      The reference to store the key in. Can be `NULL`.
+ * @param out_key_size The reference to store the key size in. Can be `NULL`.
+ *
+ * @returns            `true` if the cursor moved to a key.
+ *                     `false` if there are no more keys.
+ *
+ * @version            0.3.0
+ */
+bool apple_set_next(apple_set *set, apple_map_cursor *cursor, const void **out_key, size_t *out_key_size);
+
+/**
+ * @brief              Removes every key from the set, but keeps its capacity, like
+ *                     `apple_map_clear`.
+ * @param set          The set to clear.
+ *
+ * @version            0.3.0
+ */
+void apple_set_clear(apple_set *set);
+
+/**
+ * @brief              Frees the set object and inner buckets. Keys copied by the set itself are
+ *                     freed here too.
+ * @param set          The set object to free.
+ *
+ * @version            0.3.0
+ */
+void apple_set_free(apple_set *set);
+
+/**
+ * @brief      Frozen hashmap is an immutable snapshot of a hashmap, backed by a minimal perfect
+ *             hash. Every lookup touches exactly one slot and compares exactly one key, and the
+ *             slot array has no empty slots.
+ *
+ * @version    0.3.0
+ */
+typedef struct apple_frozen_map apple_frozen_map;
+
+/**
+ * @brief              Builds a frozen hashmap out of the entries of the hashmap.
+ * @details            Keys are copied into the frozen hashmap, so the source hashmap and its keys
+ *                     can be freed afterwards. The source hashmap is not modified.
+ *
+ * @param map          The hashmap to freeze.
+ *
+ * @returns            A newly allocated frozen hashmap or `NULL` if the allocation failed, no
+ *                     displacements that place every key into its own slot were found within the
+ *                     limited number of hash seeds tried, or the hashmap was created with a
+ *                     `value_size` larger than `sizeof(uintptr_t)`, since frozen hashmaps hold
+ *                     `uintptr_t` values only.
+ *
+ * @version            0.3.0
+ */
+apple_frozen_map *apple_map_freeze(apple_map *map);
+
+/**
+ * @brief              Resolves a key-value pair from the frozen hashmap.
+ *
+ * @param map          The frozen hashmap, from which the key-value pair will be resolved.
+ * @param key          The key to resolve.
+ * @param key_size     The size of the key.
+ * @param out_value    The reference to a value to store the resolved value.
+ *
+ * @returns            `true` if the key exists in the frozen hashmap.
+ *                     `false` otherwise.
+ *
+ * @version            0.3.0
+ */
+bool apple_frozen_map_get(apple_frozen_map *map, const void *key, size_t key_size, uintptr_t *out_value);
+
+/**
+ * @brief            Returns the number of entries in the frozen hashmap.
+ * @returns          The number of entries in the frozen hashmap.
+ *
+ * @version          0.3.0
+ */
+size_t apple_frozen_map_len(apple_frozen_map *map);
+
+/**
+ * @brief              Iterates through the frozen hashmap in slot order, using the `callback`.
+ * @details            Entries of a corrupted file, whose keys lie outside of it, are skipped, as
+ *                     `apple_frozen_map_get` never finds them either.
+ * @param map          The frozen hashmap to iterate.
+ * @param callback     The callback, that will be called on each entry.
+ * @param user         User pointer is a pointer that you can use in the `callback`.
+ *
+ * @version            0.3.0
+ */
+void apple_frozen_map_iter(apple_frozen_map *map, apple_map_callback callback, void *user);
+
+/**
+ * @brief              Writes a frozen snapshot of the hashmap into a file, that can later be
+ *                     opened with `apple_map_open_mmap`.
+ * @details            The file stores offsets instead of pointers, so it doesn't depend on the
+ *                     address it is mapped at. It uses the byte order of the machine that wrote it.
+ *                     An existing file is replaced like in `apple_frozen_map_save`.
+ *
+ * @param map          The hashmap to save.
+ * @param path         The path of the file to create or replace.
+ *
+ * @returns            `true` if the file was written successfully.
+ *                     `false` otherwise, also when the hashmap can't be frozen, for example
+ *                     because its `value_size` is larger than `sizeof(uintptr_t)`.
+ *
+ * @version            0.3.0
+ */
+bool apple_map_save(apple_map *map, const char *path);
+
+/**
+ * @brief              Writes the frozen hashmap into a file, that can later be opened with
+ *                     `apple_map_open_mmap`.
+ * @details            The image is written into `path` with a `.tmp` suffix, synced and then
+ *                     renamed over `path`, so processes, that have the previous file mapped,
+ *                     keep reading it intact, and new ones map either the old or the new file.
+ *
+ * @param map          The frozen hashmap to save.
+ * @param path         The path of the file to create or replace.
+ *
+ * @returns            `true` if the file was written successfully.
+ *                     `false` otherwise.
+ *
+ * @version            0.3.0
+ */
+bool apple_frozen_map_save(apple_frozen_map *map, const char *path);
+
+/**
+ * @brief              Maps a file written by `apple_map_save` into memory and serves lookups
+ *                     directly from the mapping, without deserializing it.
+ * @details            The mapping is read-only and shared, so processes opening the same file share
+ *                     its pages. Use `apple_frozen_map_free` to unmap it.
+ *
+ * @param path         The path of the file to map.
+ *
+ * @returns            The frozen hashmap backed by the mapping or `NULL` if the file can't be
+ *                     opened or isn't a valid hashmap image.
+ *
+ * @version            0.3.0
+ */
+apple_frozen_map *apple_map_open_mmap(const char *path);
+
+/**
+ * @brief              Frees the frozen hashmap object together with the copied keys, or unmaps
+ *                     it if it was opened with `apple_map_open_mmap`.
+ * @param map          The frozen hashmap object to free.
+ *
+ * @version            0.3.0
+ */
+void apple_frozen_map_free(apple_frozen_map *map);
+
 #endif /* _APPLE_MAP_H_ */
@@ -0,0 +1,843 @@
+/**
+ * @author    Adi Salimgereyev
+ * @brief      Benchmark harness shared by the apple map and the `std::unordered_map` drivers.
+ *             The harness generates the keys and access patterns, times every workload and
+ *             talks to the measured hashmap only through a `bench_engine`, so both drivers run
+ *             exactly the same operations on exactly the same data.
+ * @date      10/16/2026
+ * @version   0.3.0
+ */
+
+#ifndef _APPLE_MAP_BENCH_H_
+#define _APPLE_MAP_BENCH_H_
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "histogram.h"
+#include "perf.h"
+#include "trace.h"
+
+/**
+ * @brief      Operations of the measured hashmap. Keys passed into the engine stay alive until
+ *             `destroy` is called.
+ */
+typedef struct bench_engine
+{
+  const char *name;
+
+  void *(*create)(void);
+  void (*insert)(void *map, const void *key, size_t key_size, uintptr_t value);
+  bool (*get)(void *map, const void *key, size_t key_size, uintptr_t *out_value);
+  void (*remove)(void *map, const void *key, size_t key_size);
+  /** Number of entries in the hashmap. */
+  size_t (*len)(void *map);
+  /** Visits every entry and returns the sum of the values. */
+  uintptr_t (*iterate)(void *map);
+  /** Bytes of memory used by the hashmap itself, not counting the keys owned by the harness. */
+  size_t (*memory)(void *map);
+  void (*destroy)(void *map);
+  /** Removes every entry, keeping the memory for new ones. */
+  void (*clear)(void *map);
+  /** Prepares room for `additional` more entries. Can be `NULL`. */
+  void (*reserve)(void *map, size_t additional);
+} bench_engine;
+
+typedef enum bench_key_kind
+{
+  BENCH_KEYS_INT,
+  BENCH_KEYS_SHORT,
+  BENCH_KEYS_LONG,
+} bench_key_kind;
+
+typedef enum bench_distribution
+{
+  BENCH_UNIFORM,
+  BENCH_ZIPF,
+} bench_distribution;
+
+/**
+ * @brief      Distinct keys laid out one after another in a single blob.
+ */
+typedef struct bench_keys
+{
+  size_t len;
+
+  unsigned char *blob;
+  const void **keys;
+  size_t *sizes;
+} bench_keys;
+
+#define BENCH_MAX_SIZES 16
+
+typedef struct bench_options
+{
+  bool keys[3];
+  bool distributions[2];
+
+  size_t sizes[BENCH_MAX_SIZES];
+  size_t sizes_len;
+
+  /** Record the latency of every operation instead of the throughput of whole workloads. */
+  bool latency;
+
+  /** Count hardware events around every workload with `perf_event_open`. */
+  bool perf;
+
+  /** Trace to replay instead of the generated workloads, or `NULL`. */
+  const char *replay;
+} bench_options;
+
+static const char *const BENCH_KEY_NAMES[] = {"int", "short", "long"};
+static const char *const BENCH_DISTRIBUTION_NAMES[] = {"uniform", "zipf"};
+
+/* Skew of the Zipfian distribution, the value YCSB uses. */
+#define BENCH_ZIPF_THETA 0.99
+
+static inline uint64_t bench_mix(uint64_t x)
+{
+  x += 0x9e3779b97f4a7c15;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+
+  return x ^ (x >> 31);
+}
+
+static inline uint64_t bench_now_ns(void)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return (uint64_t)now.tv_sec * 1000000000u + now.tv_nsec;
+}
+
+/**
+ * @brief      Reads the cheapest clock available: the time stamp counter on x86, the monotonic
+ *             clock elsewhere. Convert ticks with `bench_ns_per_tick`.
+ */
+static inline uint64_t bench_ticks(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return bench_now_ns();
+#endif
+}
+
+/**
+ * @brief      Measures the length of a tick of `bench_ticks` in nanoseconds, once per process.
+ */
+static double bench_ns_per_tick(void)
+{
+  static double ns_per_tick = 0;
+
+  if (ns_per_tick == 0)
+  {
+    uint64_t started_ns = bench_now_ns();
+    uint64_t started_ticks = bench_ticks();
+
+    while (bench_now_ns() - started_ns < 50000000)
+      ;
+
+    ns_per_tick = (double)(bench_now_ns() - started_ns) / (double)(bench_ticks() - started_ticks);
+  }
+
+  return ns_per_tick;
+}
+
+/**
+ * @brief      Generates `len` distinct keys, starting at the key number `first`. Integer keys
+ *             are 8 bytes, short keys are decimal strings up to 20 bytes and long keys are
+ *             decimal strings behind a 48 byte prefix, like URLs or paths.
+ */
+static void bench_keys_generate(bench_keys *keys, bench_key_kind kind, size_t first, size_t len)
+{
+  static const char prefix[] = "https://example.com/accounts/sessions/resource/";
+  size_t max_size = kind == BENCH_KEYS_INT ? 8 : kind == BENCH_KEYS_SHORT ? 20 : 20 + sizeof(prefix) - 1;
+
+  keys->len = len;
+  keys->blob = (unsigned char *)malloc(len * max_size + 1);
+  keys->keys = (const void **)malloc(len * sizeof(void *));
+  keys->sizes = (size_t *)malloc(len * sizeof(size_t));
+
+  size_t offset = 0;
+
+  for (size_t i = 0; i < len; i++)
+  {
+    /* The mix is a bijection, so distinct key numbers give distinct keys. */
+    uint64_t id = bench_mix(first + i);
+    unsigned char *key = keys->blob + offset;
+    size_t size;
+
+    if (kind == BENCH_KEYS_INT)
+    {
+      memcpy(key, &id, sizeof(id));
+      size = sizeof(id);
+    }
+    else
+    {
+      size_t prefix_size = kind == BENCH_KEYS_LONG ? sizeof(prefix) - 1 : 0;
+
+      memcpy(key, prefix, prefix_size);
+      size = prefix_size + sprintf((char *)key + prefix_size, "%llu", (unsigned long long)id);
+    }
+
+    keys->keys[i] = key;
+    keys->sizes[i] = size;
+
+    offset += size;
+  }
+}
+
+static void bench_keys_free(bench_keys *keys)
+{
+  free(keys->blob);
+  free((void *)keys->keys);
+  free(keys->sizes);
+}
+
+/**
+ * @brief      Generates `len` indexes in `[0, range)`, either uniformly or following a Zipfian
+ *             distribution, where a few hot keys get most of the accesses. Hot ranks are
+ *             scattered over the key space, so hot keys aren't neighbours in insertion order.
+ */
+static size_t *bench_pattern_generate(bench_distribution distribution, size_t range, size_t len, uint64_t seed)
+{
+  size_t *pattern = (size_t *)malloc(len * sizeof(size_t));
+
+  if (distribution == BENCH_UNIFORM)
+  {
+    for (size_t i = 0; i < len; i++)
+    {
+      pattern[i] = bench_mix(seed + i) % range;
+    }
+
+    return pattern;
+  }
+
+  /* Gray et al., "Quickly generating billion-record synthetic databases". */
+  double zeta_n = 0;
+
+  for (size_t i = 1; i <= range; i++)
+  {
+    zeta_n += 1 / pow((double)i, BENCH_ZIPF_THETA);
+  }
+
+  double zeta_2 = 1 + 1 / pow(2, BENCH_ZIPF_THETA);
+  double alpha = 1 / (1 - BENCH_ZIPF_THETA);
+  double eta = (1 - pow(2.0 / range, 1 - BENCH_ZIPF_THETA)) / (1 - zeta_2 / zeta_n);
+
+  for (size_t i = 0; i < len; i++)
+  {
+    double u = (double)(bench_mix(seed + i) >> 11) / (double)(1ull << 53);
+    double uz = u * zeta_n;
+    size_t rank;
+
+    if (uz < 1)
+      rank = 0;
+    else if (uz < zeta_2)
+      rank = 1;
+    else
+      rank = (size_t)(range * pow(eta * u - eta + 1, alpha));
+
+    if (rank >= range)
+      rank = range - 1;
+
+    pattern[i] = bench_mix(rank ^ 0x5bd1e995) % range;
+  }
+
+  return pattern;
+}
+
+/**
+ * @brief      Generates a random permutation of `[0, len)`.
+ */
+static size_t *bench_permutation_generate(size_t len, uint64_t seed)
+{
+  size_t *permutation = (size_t *)malloc(len * sizeof(size_t));
+
+  for (size_t i = 0; i < len; i++)
+  {
+    permutation[i] = i;
+  }
+
+  for (size_t i = len; i > 1; i--)
+  {
+    size_t j = bench_mix(seed + i) % i;
+    size_t swap = permutation[i - 1];
+
+    permutation[i - 1] = permutation[j];
+    permutation[j] = swap;
+  }
+
+  return permutation;
+}
+
+/* Hardware counters of the running workloads, NULL unless requested with `--perf`. */
+static perf_counters *bench_perf;
+
+static inline uint64_t bench_start(void)
+{
+  if (bench_perf != NULL)
+    perf_counters_start(bench_perf);
+
+  return bench_now_ns();
+}
+
+/**
+ * @brief      Ends the workload begun by `bench_start` and returns its duration in nanoseconds,
+ *             reading the hardware counters into `out_counts`, if they are enabled.
+ */
+static inline uint64_t bench_stop(uint64_t started, uint64_t out_counts[PERF_COUNTERS_LEN])
+{
+  uint64_t elapsed = bench_now_ns() - started;
+
+  if (bench_perf != NULL)
+    perf_counters_stop(bench_perf, out_counts);
+
+  return elapsed;
+}
+
+static void bench_report_line(const bench_engine *engine, const char *workload, const char *keys,
+                              const char *distribution, size_t size, size_t ops, uint64_t elapsed,
+                              const uint64_t counts[PERF_COUNTERS_LEN], double bytes_per_entry)
+{
+  double ns_per_op = (double)elapsed / ops;
+
+  printf("%-14s %-9s %-6s %-8s %10zu %14.0f %10.2f %12.2f",
+         engine->name, workload, keys, distribution, size, 1e9 / ns_per_op, ns_per_op,
+         bytes_per_entry);
+
+  if (bench_perf != NULL)
+  {
+    for (int i = 0; i < PERF_COUNTERS_LEN; i++)
+    {
+      if (counts[i] == PERF_UNAVAILABLE)
+        printf(" %10s", "-");
+      else
+        printf(" %10.2f", (double)counts[i] / ops);
+    }
+  }
+
+  printf("\n");
+}
+
+static void bench_report(const bench_engine *engine, const char *workload, bench_key_kind kind,
+                         bench_distribution distribution, size_t size, size_t ops,
+                         uint64_t elapsed, const uint64_t counts[PERF_COUNTERS_LEN],
+                         double bytes_per_entry)
+{
+  bench_report_line(engine, workload, BENCH_KEY_NAMES[kind], BENCH_DISTRIBUTION_NAMES[distribution],
+                    size, ops, elapsed, counts, bytes_per_entry);
+}
+
+static void bench_report_latency(const bench_engine *engine, const char *operation,
+                                 const char *keys, const char *distribution, size_t size,
+                                 const histogram *h)
+{
+  printf("%-14s %-9s %-6s %-8s %10zu %10llu %10llu %10llu %12llu\n",
+         engine->name, operation, keys, distribution, size,
+         (unsigned long long)histogram_percentile(h, 50),
+         (unsigned long long)histogram_percentile(h, 99),
+         (unsigned long long)histogram_percentile(h, 99.9),
+         (unsigned long long)h->max);
+}
+
+/* Values are summed into here, so the compiler can't drop lookups as dead code. */
+static volatile uintptr_t bench_sink;
+
+static void bench_run_one(const bench_engine *engine, bench_key_kind kind,
+                          bench_distribution distribution, size_t size)
+{
+  bench_keys hits, misses;
+
+  bench_keys_generate(&hits, kind, 0, size);
+  bench_keys_generate(&misses, kind, size, size);
+
+  size_t *pattern = bench_pattern_generate(distribution, size, size, 1);
+  size_t *order = bench_permutation_generate(size, 2);
+  uint64_t counts[PERF_COUNTERS_LEN];
+  uintptr_t sum = 0;
+
+  void *map = engine->create();
+
+  /* insert */
+  uint64_t started = bench_start();
+
+  for (size_t i = 0; i < size; i++)
+  {
+    engine->insert(map, hits.keys[i], hits.sizes[i], i);
+  }
+
+  uint64_t elapsed = bench_stop(started, counts);
+  double bytes_per_entry = (double)engine->memory(map) / size;
+
+  bench_report(engine, "insert", kind, distribution, size, size, elapsed, counts, bytes_per_entry);
+
+  /* get-hit */
+  started = bench_start();
+
+  for (size_t i = 0; i < size; i++)
+  {
+    uintptr_t value = 0;
+
+    engine->get(map, hits.keys[pattern[i]], hits.sizes[pattern[i]], &value);
+    sum += value;
+  }
+
+  bench_report(engine, "get-hit", kind, distribution, size, size,
+               bench_stop(started, counts), counts, bytes_per_entry);
+
+  /* get-miss */
+  started = bench_start();
+
+  for (size_t i = 0; i < size; i++)
+  {
+    uintptr_t value = 0;
+
+    sum += engine->get(map, misses.keys[pattern[i]], misses.sizes[pattern[i]], &value);
+  }
+
+  bench_report(engine, "get-miss", kind, distribution, size, size,
+               bench_stop(started, counts), counts, bytes_per_entry);
+
+  /* iterate */
+  started = bench_start();
+  sum += engine->iterate(map);
+
+  bench_report(engine, "iterate", kind, distribution, size, size,
+               bench_stop(started, counts), counts, bytes_per_entry);
+
+  /* mixed: 90% lookups, 5% updates or inserts, 5% removals */
+  started = bench_start();
+
+  for (size_t i = 0; i < size; i++)
+  {
+    size_t index = pattern[i];
+    uint64_t roll = bench_mix(i ^ 0x2545f491) % 20;
+
+    if (roll == 0)
+    {
+      engine->insert(map, hits.keys[index], hits.sizes[index], i);
+    }
+    else if (roll == 1)
+    {
+      engine->remove(map, hits.keys[index], hits.sizes[index]);
+    }
+    else
+    {
+      uintptr_t value = 0;
+
+      engine->get(map, hits.keys[index], hits.sizes[index], &value);
+      sum += value;
+    }
+  }
+
+  bench_report(engine, "mixed", kind, distribution, size, size,
+               bench_stop(started, counts), counts, bytes_per_entry);
+
+  /* remove, in an order unrelated to insertion */
+  started = bench_start();
+
+  for (size_t i = 0; i < size; i++)
+  {
+    engine->remove(map, hits.keys[order[i]], hits.sizes[order[i]]);
+  }
+
+  bench_report(engine, "remove", kind, distribution, size, size,
+               bench_stop(started, counts), counts, bytes_per_entry);
+
+  engine->destroy(map);
+
+  bench_sink += sum;
+
+  free(pattern);
+  free(order);
+  bench_keys_free(&hits);
+  bench_keys_free(&misses);
+}
+
+enum
+{
+  BENCH_LATENCY_INSERT,
+  BENCH_LATENCY_GET_HIT,
+  BENCH_LATENCY_GET_MISS,
+  BENCH_LATENCY_REMOVE,
+  BENCH_LATENCY_LEN,
+};
+
+static const char *const BENCH_LATENCY_NAMES[] = {"insert", "get-hit", "get-miss", "remove"};
+
+#define BENCH_TIME(h, ns_per_tick, operation)                                          \
+  do                                                                                   \
+  {                                                                                    \
+    uint64_t started_ = bench_ticks();                                                 \
+    operation;                                                                         \
+    histogram_record((h), (uint64_t)((bench_ticks() - started_) * (ns_per_tick)));    \
+  } while (0)
+
+/**
+ * @brief      Grows an empty hashmap to `size` entries, timing every single operation, so the
+ *             stalls of resizes show up in the tail of the distribution instead of being
+ *             averaged away. Every insert is followed by a lookup of an inserted key and a
+ *             lookup of an absent key, then all keys are removed.
+ */
+static void bench_run_latency(const bench_engine *engine, bench_key_kind kind,
+                              bench_distribution distribution, size_t size)
+{
+  bench_keys hits, misses;
+
+  bench_keys_generate(&hits, kind, 0, size);
+  bench_keys_generate(&misses, kind, size, size);
+
+  size_t *pattern = bench_pattern_generate(distribution, size, size, 1);
+  size_t *order = bench_permutation_generate(size, 2);
+  histogram *histograms = (histogram *)malloc(BENCH_LATENCY_LEN * sizeof(histogram));
+  double ns_per_tick = bench_ns_per_tick();
+  uintptr_t sum = 0;
+
+  for (int i = 0; i < BENCH_LATENCY_LEN; i++)
+  {
+    histogram_reset(&histograms[i]);
+  }
+
+  void *map = engine->create();
+
+  for (size_t i = 0; i < size; i++)
+  {
+    size_t hit = pattern[i] % (i + 1);
+    uintptr_t value = 0;
+
+    BENCH_TIME(&histograms[BENCH_LATENCY_INSERT], ns_per_tick,
+               engine->insert(map, hits.keys[i], hits.sizes[i], i));
+    BENCH_TIME(&histograms[BENCH_LATENCY_GET_HIT], ns_per_tick,
+               engine->get(map, hits.keys[hit], hits.sizes[hit], &value));
+    BENCH_TIME(&histograms[BENCH_LATENCY_GET_MISS], ns_per_tick,
+               sum += engine->get(map, misses.keys[pattern[i]], misses.sizes[pattern[i]], &value));
+
+    sum += value;
+  }
+
+  for (size_t i = 0; i < size; i++)
+  {
+    BENCH_TIME(&histograms[BENCH_LATENCY_REMOVE], ns_per_tick,
+               engine->remove(map, hits.keys[order[i]], hits.sizes[order[i]]));
+  }
+
+  engine->destroy(map);
+
+  for (int i = 0; i < BENCH_LATENCY_LEN; i++)
+  {
+    bench_report_latency(engine, BENCH_LATENCY_NAMES[i], BENCH_KEY_NAMES[kind],
+                         BENCH_DISTRIBUTION_NAMES[distribution], size, &histograms[i]);
+  }
+
+  bench_sink += sum;
+
+  free(histograms);
+  free(pattern);
+  free(order);
+  bench_keys_free(&hits);
+  bench_keys_free(&misses);
+}
+
+static inline uintptr_t bench_replay_op(const bench_engine *engine, void *map, const trace_op *op)
+{
+  uintptr_t value = 0;
+
+  switch (op->kind)
+  {
+  case TRACE_GET:
+    value += engine->get(map, op->key, op->key_size, &value);
+    break;
+  case TRACE_INSERT:
+    engine->insert(map, op->key, op->key_size, (uintptr_t)op->value);
+    break;
+  case TRACE_GET_OR_INSERT:
+  case TRACE_ENTRY:
+    if (!engine->get(map, op->key, op->key_size, &value))
+      engine->insert(map, op->key, op->key_size, op->kind == TRACE_ENTRY ? 0 : (uintptr_t)op->value);
+    break;
+  case TRACE_REMOVE:
+    engine->remove(map, op->key, op->key_size);
+    break;
+  case TRACE_CLEAR:
+    engine->clear(map);
+    break;
+  default:
+    if (engine->reserve != NULL)
+      engine->reserve(map, (size_t)op->value);
+    break;
+  }
+
+  return value;
+}
+
+/**
+ * @brief      Re-executes a recorded trace against the engine twice: once as fast as possible
+ *             for the throughput, and once timing every operation for the latency distribution
+ *             of each kind of operation.
+ */
+static void bench_run_replay(const bench_engine *engine, const trace_file *trace)
+{
+  const char *mode = trace->mode == TRACE_FILE_KEYS ? "keys" : "ids";
+  uint64_t counts[PERF_COUNTERS_LEN];
+  uintptr_t sum = 0;
+
+  void *map = engine->create();
+  uint64_t started = bench_start();
+
+  for (size_t i = 0; i < trace->len; i++)
+  {
+    sum += bench_replay_op(engine, map, &trace->ops[i]);
+  }
+
+  uint64_t elapsed = bench_stop(started, counts);
+  size_t entries = engine->len(map);
+
+  bench_report_line(engine, "replay", "trace", mode, trace->len, trace->len, elapsed, counts,
+                    entries > 0 ? (double)engine->memory(map) / entries : 0);
+  engine->destroy(map);
+
+  histogram *histograms = (histogram *)malloc(TRACE_OPS_LEN * sizeof(histogram));
+  double ns_per_tick = bench_ns_per_tick();
+
+  for (int i = 0; i < TRACE_OPS_LEN; i++)
+  {
+    histogram_reset(&histograms[i]);
+  }
+
+  map = engine->create();
+
+  for (size_t i = 0; i < trace->len; i++)
+  {
+    const trace_op *op = &trace->ops[i];
+
+    BENCH_TIME(&histograms[op->kind], ns_per_tick, sum += bench_replay_op(engine, map, op));
+  }
+
+  engine->destroy(map);
+
+  printf("\n%-14s %-9s %-6s %-8s %10s %10s %10s %10s %12s\n",
+         "engine", "operation", "keys", "dist", "count", "p50 ns", "p99 ns", "p99.9 ns", "max ns");
+
+  for (int i = TRACE_GET; i < TRACE_OPS_LEN; i++)
+  {
+    if (histograms[i].total > 0)
+      bench_report_latency(engine, TRACE_OP_NAMES[i], "trace", mode, histograms[i].total, &histograms[i]);
+  }
+
+  bench_sink += sum;
+
+  free(histograms);
+}
+
+static bool bench_parse_list(const char *list, const char *const *names, size_t names_len, bool *out_selected)
+{
+  memset(out_selected, 0, names_len * sizeof(bool));
+
+  while (*list != '\0')
+  {
+    size_t len = strcspn(list, ",");
+    bool found = false;
+
+    for (size_t i = 0; i < names_len; i++)
+    {
+      if (strlen(names[i]) == len && strncmp(names[i], list, len) == 0)
+      {
+        out_selected[i] = found = true;
+      }
+    }
+
+    if (!found)
+    {
+      return false;
+    }
+
+    list += len + (list[len] == ',');
+  }
+
+  return true;
+}
+
+static bool bench_parse_options(bench_options *options, int argc, char **argv)
+{
+  static const size_t default_sizes[] = {1000, 10000, 100000, 1000000};
+
+  options->keys[0] = options->keys[1] = options->keys[2] = true;
+  options->distributions[0] = options->distributions[1] = true;
+  options->sizes_len = sizeof(default_sizes) / sizeof(default_sizes[0]);
+  memcpy(options->sizes, default_sizes, sizeof(default_sizes));
+  options->latency = false;
+  options->perf = false;
+  options->replay = NULL;
+
+  for (int i = 1; i < argc; i++)
+  {
+    const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+
+    if (strcmp(argv[i], "--latency") == 0)
+    {
+      options->latency = true;
+      continue;
+    }
+
+    if (strcmp(argv[i], "--perf") == 0)
+    {
+      options->perf = true;
+      continue;
+    }
+
+    if (strcmp(argv[i], "--replay") == 0 && value != NULL)
+    {
+      options->replay = value;
+    }
+    else if (strcmp(argv[i], "--keys") == 0 && value != NULL)
+    {
+      if (!bench_parse_list(value, BENCH_KEY_NAMES, 3, options->keys))
+        return false;
+    }
+    else if (strcmp(argv[i], "--dist") == 0 && value != NULL)
+    {
+      if (!bench_parse_list(value, BENCH_DISTRIBUTION_NAMES, 2, options->distributions))
+        return false;
+    }
+    else if (strcmp(argv[i], "--sizes") == 0 && value != NULL)
+    {
+      options->sizes_len = 0;
+
+      for (const char *size = value; *size != '\0' && options->sizes_len < BENCH_MAX_SIZES;)
+      {
+        char *end;
+
+        options->sizes[options->sizes_len++] = strtoull(size, &end, 10);
+
+        if (end == size || options->sizes[options->sizes_len - 1] == 0)
+          return false;
+
+        size = end + (*end == ',');
+      }
+    }
+    else
+    {
+      return false;
+    }
+
+    i++;
+  }
+
+  return true;
+}
+
+/**
+ * @brief      Runs every selected combination of key kind, distribution and size against the
+ *             engine and prints one line per workload, or per operation type in latency mode.
+ */
+static int bench_main(const bench_engine *engine, int argc, char **argv)
+{
+  bench_options options;
+
+  if (!bench_parse_options(&options, argc, argv))
+  {
+    fprintf(stderr,
+            "usage: %s [--keys int,short,long] [--dist uniform,zipf] [--sizes 1000,1000000,...] [--latency] [--perf]\n"
+            "       %s --replay trace [--perf]\n",
+            argv[0], argv[0]);
+    return 1;
+  }
+
+  trace_file trace;
+
+  if (options.replay != NULL && !trace_file_load(&trace, options.replay))
+  {
+    fprintf(stderr, "%s: %s is not a readable trace\n", argv[0], options.replay);
+    trace_file_free(&trace);
+    return 1;
+  }
+
+  perf_counters counters;
+
+  if (options.perf && (!options.latency || options.replay != NULL))
+  {
+    if (perf_counters_open(&counters))
+    {
+      bench_perf = &counters;
+    }
+    else
+    {
+      fprintf(stderr, "%s: no hardware counters available, check /proc/sys/kernel/perf_event_paranoid\n",
+              argv[0]);
+      options.perf = false;
+    }
+  }
+
+  if (options.latency && options.replay == NULL)
+  {
+    printf("%-14s %-9s %-6s %-8s %10s %10s %10s %10s %12s\n",
+           "engine", "operation", "keys", "dist", "size", "p50 ns", "p99 ns", "p99.9 ns", "max ns");
+  }
+  else
+  {
+    printf("%-14s %-9s %-6s %-8s %10s %14s %10s %12s",
+           "engine", "workload", "keys", "dist", "size", "ops/sec", "ns/op", "bytes/entry");
+
+    if (options.perf)
+    {
+      for (int i = 0; i < PERF_COUNTERS_LEN; i++)
+      {
+        printf(" %10s", PERF_COUNTER_NAMES[i]);
+      }
+    }
+
+    printf("\n");
+  }
+
+  if (options.replay != NULL)
+  {
+    bench_run_replay(engine, &trace);
+    trace_file_free(&trace);
+    options.sizes_len = 0;
+  }
+
+  for (size_t s = 0; s < options.sizes_len; s++)
+  {
+    for (int k = 0; k < 3; k++)
+    {
+      for (int d = 0; d < 2; d++)
+      {
+        if (options.keys[k] && options.distributions[d])
+        {
+          if (options.latency)
+            bench_run_latency(engine, (bench_key_kind)k, (bench_distribution)d, options.sizes[s]);
+          else
+            bench_run_one(engine, (bench_key_kind)k, (bench_distribution)d, options.sizes[s]);
+        }
+      }
+    }
+  }
+
+  if (bench_perf != NULL)
+  {
+    perf_counters_close(bench_perf);
+    bench_perf = NULL;
+  }
+
+  return 0;
+}
+
+#endif /* _APPLE_MAP_BENCH_H_ */
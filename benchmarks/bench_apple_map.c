@@ -0,0 +1,87 @@
+#include "bench.h"
+#include "../apple_map.h"
+
+static void *engine_create(void)
+{
+  return apple_map_new();
+}
+
+static void engine_insert(void *map, const void *key, size_t key_size, uintptr_t value)
+{
+  apple_map_insert(map, key, key_size, value);
+}
+
+static bool engine_get(void *map, const void *key, size_t key_size, uintptr_t *out_value)
+{
+  return apple_map_get(map, key, key_size, out_value);
+}
+
+static void engine_remove(void *map, const void *key, size_t key_size)
+{
+  apple_map_remove(map, key, key_size);
+}
+
+static size_t engine_len(void *map)
+{
+  return apple_map_len(map);
+}
+
+static void sum_values(void *key, size_t key_size, uintptr_t value, void *user)
+{
+  (void)key;
+  (void)key_size;
+
+  *(uintptr_t *)user += value;
+}
+
+static uintptr_t engine_iterate(void *map)
+{
+  uintptr_t sum = 0;
+
+  apple_map_iter(map, sum_values, &sum);
+
+  return sum;
+}
+
+static size_t engine_memory(void *map)
+{
+  apple_map_memory_report report;
+
+  apple_map_memory_usage(map, &report);
+
+  return report.total_bytes;
+}
+
+static void engine_destroy(void *map)
+{
+  apple_map_free(map);
+}
+
+static void engine_clear(void *map)
+{
+  apple_map_clear(map);
+}
+
+static void engine_reserve(void *map, size_t additional)
+{
+  apple_map_reserve(map, additional);
+}
+
+static const bench_engine APPLE_MAP_ENGINE = {
+    .name = "apple_map",
+    .create = engine_create,
+    .insert = engine_insert,
+    .get = engine_get,
+    .remove = engine_remove,
+    .len = engine_len,
+    .iterate = engine_iterate,
+    .memory = engine_memory,
+    .destroy = engine_destroy,
+    .clear = engine_clear,
+    .reserve = engine_reserve,
+};
+
+int main(int argc, char **argv)
+{
+  return bench_main(&APPLE_MAP_ENGINE, argc, argv);
+}
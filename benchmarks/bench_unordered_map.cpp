@@ -0,0 +1,137 @@
+#include "bench.h"
+
+#include <string_view>
+#include <unordered_map>
+
+/* Counts the bytes held by the container, so bytes per entry can be compared with apple map. */
+static size_t allocated_bytes = 0;
+
+template <typename T>
+struct counting_allocator
+{
+  using value_type = T;
+
+  counting_allocator() = default;
+
+  template <typename U>
+  counting_allocator(const counting_allocator<U> &) {}
+
+  T *allocate(size_t count)
+  {
+    allocated_bytes += count * sizeof(T);
+    return std::allocator<T>().allocate(count);
+  }
+
+  void deallocate(T *pointer, size_t count)
+  {
+    allocated_bytes -= count * sizeof(T);
+    std::allocator<T>().deallocate(pointer, count);
+  }
+
+  template <typename U>
+  bool operator==(const counting_allocator<U> &) const { return true; }
+
+  template <typename U>
+  bool operator!=(const counting_allocator<U> &) const { return false; }
+};
+
+using map_type = std::unordered_map<std::string_view, uintptr_t, std::hash<std::string_view>,
+                                    std::equal_to<std::string_view>,
+                                    counting_allocator<std::pair<const std::string_view, uintptr_t>>>;
+
+static inline map_type *as_map(void *map)
+{
+  return static_cast<map_type *>(map);
+}
+
+static inline std::string_view as_key(const void *key, size_t key_size)
+{
+  return std::string_view(static_cast<const char *>(key), key_size);
+}
+
+static void *engine_create()
+{
+  return new map_type();
+}
+
+static void engine_insert(void *map, const void *key, size_t key_size, uintptr_t value)
+{
+  (*as_map(map))[as_key(key, key_size)] = value;
+}
+
+static bool engine_get(void *map, const void *key, size_t key_size, uintptr_t *out_value)
+{
+  auto found = as_map(map)->find(as_key(key, key_size));
+
+  if (found == as_map(map)->end())
+  {
+    return false;
+  }
+
+  *out_value = found->second;
+
+  return true;
+}
+
+static void engine_remove(void *map, const void *key, size_t key_size)
+{
+  as_map(map)->erase(as_key(key, key_size));
+}
+
+static size_t engine_len(void *map)
+{
+  return as_map(map)->size();
+}
+
+static uintptr_t engine_iterate(void *map)
+{
+  uintptr_t sum = 0;
+
+  for (const auto &entry : *as_map(map))
+  {
+    sum += entry.second;
+  }
+
+  return sum;
+}
+
+static size_t engine_memory(void *map)
+{
+  (void)map;
+
+  return allocated_bytes + sizeof(map_type);
+}
+
+static void engine_destroy(void *map)
+{
+  delete as_map(map);
+}
+
+static void engine_clear(void *map)
+{
+  as_map(map)->clear();
+}
+
+static void engine_reserve(void *map, size_t additional)
+{
+  as_map(map)->reserve(as_map(map)->size() + additional);
+}
+
+static const bench_engine UNORDERED_MAP_ENGINE = {
+    "unordered_map",
+    engine_create,
+    engine_insert,
+    engine_get,
+    engine_remove,
+    engine_len,
+    engine_iterate,
+    engine_memory,
+    engine_destroy,
+    engine_clear,
+    engine_reserve,
+};
+
+int main(int argc, char **argv)
+{
+  return bench_main(&UNORDERED_MAP_ENGINE, argc, argv);
+}
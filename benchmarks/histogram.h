@@ -0,0 +1,96 @@
+/**
+ * @author    Adi Salimgereyev
+ * @brief      Log-linear latency histogram in the style of HdrHistogram. Values below 64 are
+ *             recorded exactly, larger values keep 5 significant bits, so every recorded value
+ *             is within about 3% of its true value, with a fixed 15 KiB footprint.
+ * @date      10/16/2026
+ * @version   0.3.0
+ */
+
+#ifndef _APPLE_MAP_HISTOGRAM_H_
+#define _APPLE_MAP_HISTOGRAM_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#define HISTOGRAM_SUB_BITS 5
+#define HISTOGRAM_SUB_LEN (1 << HISTOGRAM_SUB_BITS)
+#define HISTOGRAM_LEN ((64 - HISTOGRAM_SUB_BITS + 1) * HISTOGRAM_SUB_LEN)
+
+typedef struct histogram
+{
+  uint64_t counts[HISTOGRAM_LEN];
+  uint64_t total;
+  uint64_t max;
+} histogram;
+
+static inline void histogram_reset(histogram *h)
+{
+  memset(h, 0, sizeof(histogram));
+}
+
+static inline unsigned histogram_index(uint64_t value)
+{
+  if (value < 2 * HISTOGRAM_SUB_LEN)
+  {
+    return (unsigned)value;
+  }
+
+  unsigned exponent = 63 - __builtin_clzll(value);
+  uint64_t mantissa = value >> (exponent - HISTOGRAM_SUB_BITS);
+
+  return (exponent - HISTOGRAM_SUB_BITS) * HISTOGRAM_SUB_LEN + (unsigned)mantissa;
+}
+
+/**
+ * @brief      Returns the largest value, that is recorded into the bucket `index`.
+ */
+static inline uint64_t histogram_bucket_max(unsigned index)
+{
+  if (index < 2 * HISTOGRAM_SUB_LEN)
+  {
+    return index;
+  }
+
+  unsigned exponent = index / HISTOGRAM_SUB_LEN + HISTOGRAM_SUB_BITS - 1;
+  uint64_t mantissa = index % HISTOGRAM_SUB_LEN + HISTOGRAM_SUB_LEN;
+
+  return ((mantissa + 1) << (exponent - HISTOGRAM_SUB_BITS)) - 1;
+}
+
+static inline void histogram_record(histogram *h, uint64_t value)
+{
+  h->counts[histogram_index(value)]++;
+  h->total++;
+
+  if (value > h->max)
+    h->max = value;
+}
+
+/**
+ * @brief      Returns the value below or at which `percentile` percent of recorded values are.
+ */
+static inline uint64_t histogram_percentile(const histogram *h, double percentile)
+{
+  uint64_t wanted = (uint64_t)(h->total * percentile / 100);
+  uint64_t seen = 0;
+
+  if (wanted == 0)
+    wanted = 1;
+
+  for (unsigned i = 0; i < HISTOGRAM_LEN; i++)
+  {
+    seen += h->counts[i];
+
+    if (seen >= wanted)
+    {
+      uint64_t value = histogram_bucket_max(i);
+
+      return value < h->max ? value : h->max;
+    }
+  }
+
+  return h->max;
+}
+
+#endif /* _APPLE_MAP_HISTOGRAM_H_ */
@@ -0,0 +1,177 @@
+/**
+ * @author    Adi Salimgereyev
+ * @brief      Hardware performance counters through `perf_event_open`, for the benchmark
+ *             harness. Counters are opened one by one, so the ones the CPU or the kernel doesn't
+ *             provide are simply reported as unavailable, and the counts are scaled when the
+ *             kernel had to multiplex them. On anything but Linux no counter is available.
+ * @date      10/16/2026
+ * @version   0.3.0
+ */
+
+#ifndef _APPLE_MAP_PERF_H_
+#define _APPLE_MAP_PERF_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+typedef enum perf_counter
+{
+  PERF_CYCLES,
+  PERF_INSTRUCTIONS,
+  PERF_L1D_MISSES,
+  PERF_LLC_MISSES,
+  PERF_DTLB_MISSES,
+  PERF_BRANCH_MISSES,
+  PERF_COUNTERS_LEN,
+} perf_counter;
+
+static const char *const PERF_COUNTER_NAMES[] = {
+    "cycles", "instr", "L1d-miss", "LLC-miss", "dTLB-miss", "br-miss"};
+
+/* Count of a counter, that couldn't be opened or didn't run at all. */
+#define PERF_UNAVAILABLE UINT64_MAX
+
+typedef struct perf_counters
+{
+  int fds[PERF_COUNTERS_LEN];
+} perf_counters;
+
+#ifdef __linux__
+
+static int perf_open_one(uint32_t type, uint64_t config)
+{
+  struct perf_event_attr attr;
+
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = type;
+  attr.config = config;
+  attr.disabled = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+  return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+#define PERF_CACHE_MISS(cache) \
+  ((cache) | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+
+/**
+ * @brief      Opens the counters of the calling thread.
+ *
+ * @returns    whether at least one counter could be opened
+ */
+static bool perf_counters_open(perf_counters *counters)
+{
+  bool opened = false;
+
+  counters->fds[PERF_CYCLES] = perf_open_one(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+  counters->fds[PERF_INSTRUCTIONS] = perf_open_one(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+  counters->fds[PERF_L1D_MISSES] = perf_open_one(PERF_TYPE_HW_CACHE, PERF_CACHE_MISS(PERF_COUNT_HW_CACHE_L1D));
+  counters->fds[PERF_LLC_MISSES] = perf_open_one(PERF_TYPE_HW_CACHE, PERF_CACHE_MISS(PERF_COUNT_HW_CACHE_LL));
+  counters->fds[PERF_DTLB_MISSES] = perf_open_one(PERF_TYPE_HW_CACHE, PERF_CACHE_MISS(PERF_COUNT_HW_CACHE_DTLB));
+  counters->fds[PERF_BRANCH_MISSES] = perf_open_one(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+
+  for (int i = 0; i < PERF_COUNTERS_LEN; i++)
+  {
+    opened |= counters->fds[i] >= 0;
+  }
+
+  return opened;
+}
+
+static void perf_counters_start(perf_counters *counters)
+{
+  for (int i = 0; i < PERF_COUNTERS_LEN; i++)
+  {
+    if (counters->fds[i] < 0)
+      continue;
+
+    ioctl(counters->fds[i], PERF_EVENT_IOC_RESET, 0);
+    ioctl(counters->fds[i], PERF_EVENT_IOC_ENABLE, 0);
+  }
+}
+
+/**
+ * @brief      Stops the counters and reads them into `out_counts`, scaled up by the share of
+ *             time the counter was actually scheduled on the CPU.
+ */
+static void perf_counters_stop(perf_counters *counters, uint64_t out_counts[PERF_COUNTERS_LEN])
+{
+  for (int i = 0; i < PERF_COUNTERS_LEN; i++)
+  {
+    if (counters->fds[i] >= 0)
+      ioctl(counters->fds[i], PERF_EVENT_IOC_DISABLE, 0);
+  }
+
+  for (int i = 0; i < PERF_COUNTERS_LEN; i++)
+  {
+    /* value, time enabled, time running */
+    uint64_t read_values[3];
+
+    out_counts[i] = PERF_UNAVAILABLE;
+
+    if (counters->fds[i] < 0 ||
+        read(counters->fds[i], read_values, sizeof(read_values)) != sizeof(read_values) ||
+        read_values[2] == 0)
+      continue;
+
+    out_counts[i] = (uint64_t)((double)read_values[0] * read_values[1] / read_values[2]);
+  }
+}
+
+static void perf_counters_close(perf_counters *counters)
+{
+  for (int i = 0; i < PERF_COUNTERS_LEN; i++)
+  {
+    if (counters->fds[i] >= 0)
+      close(counters->fds[i]);
+
+    counters->fds[i] = -1;
+  }
+}
+
+#else
+
+static bool perf_counters_open(perf_counters *counters)
+{
+  for (int i = 0; i < PERF_COUNTERS_LEN; i++)
+  {
+    counters->fds[i] = -1;
+  }
+
+  return false;
+}
+
+static void perf_counters_start(perf_counters *counters)
+{
+  (void)counters;
+}
+
+static void perf_counters_stop(perf_counters *counters, uint64_t out_counts[PERF_COUNTERS_LEN])
+{
+  (void)counters;
+
+  for (int i = 0; i < PERF_COUNTERS_LEN; i++)
+  {
+    out_counts[i] = PERF_UNAVAILABLE;
+  }
+}
+
+static void perf_counters_close(perf_counters *counters)
+{
+  (void)counters;
+}
+
+#endif
+
+#endif /* _APPLE_MAP_PERF_H_ */
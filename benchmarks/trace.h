@@ -0,0 +1,305 @@
+/**
+ * @author    Adi Salimgereyev
+ * @brief      Reader of the operation traces written by `apple_map_trace_start`, used by the
+ *             replay mode of the benchmark harness. Traces of key fingerprints are replayed with
+ *             synthetic keys of the recorded sizes, derived from the fingerprints, or numbered
+ *             by distinct fingerprint when they are too short to hold one.
+ * @date      10/16/2026
+ * @version   0.3.0
+ */
+
+#ifndef _APPLE_MAP_TRACE_H_
+#define _APPLE_MAP_TRACE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Mirrors the trace format documented at `apple_map_trace_start`. */
+#define TRACE_FILE_MAGIC 0x45435254454c5041ull /* "APLETRCE" */
+#define TRACE_FILE_VERSION 1u
+
+typedef enum trace_op_kind
+{
+  TRACE_GET = 1,
+  TRACE_INSERT = 2,
+  TRACE_GET_OR_INSERT = 3,
+  TRACE_ENTRY = 4,
+  TRACE_REMOVE = 5,
+  TRACE_RESERVE = 6,
+  TRACE_CLEAR = 7,
+  TRACE_OPS_LEN,
+} trace_op_kind;
+
+static const char *const TRACE_OP_NAMES[] = {
+    "", "get", "insert", "get-ins", "entry", "remove", "reserve", "clear"};
+
+typedef enum trace_file_mode
+{
+  TRACE_FILE_KEYS,
+  TRACE_FILE_KEY_IDS,
+} trace_file_mode;
+
+typedef struct trace_op
+{
+  trace_op_kind kind;
+  uint32_t hash;
+  uint64_t value;
+
+  const void *key;
+  size_t key_size;
+} trace_op;
+
+/**
+ * @brief      Decoded trace. Keys point into `data` or, for traces of fingerprints, into `keys`.
+ */
+typedef struct trace_file
+{
+  trace_file_mode mode;
+
+  unsigned char *data;
+  size_t size;
+
+  unsigned char *keys;
+
+  trace_op *ops;
+  size_t len;
+} trace_file;
+
+/* Key of fewer than 8 bytes in a trace of fingerprints, numbered after sorting. */
+typedef struct trace_short_key
+{
+  uint64_t id;
+  size_t key_size;
+  unsigned char *key;
+} trace_short_key;
+
+static int trace_short_key_compare(const void *left, const void *right)
+{
+  const trace_short_key *a = (const trace_short_key *)left;
+  const trace_short_key *b = (const trace_short_key *)right;
+
+  if (a->key_size != b->key_size)
+    return a->key_size < b->key_size ? -1 : 1;
+
+  if (a->id != b->id)
+    return a->id < b->id ? -1 : 1;
+
+  return 0;
+}
+
+static bool trace_read_varint(const unsigned char **cursor, const unsigned char *end, uint64_t *out_value)
+{
+  uint64_t value = 0;
+
+  for (unsigned shift = 0; shift < 64; shift += 7)
+  {
+    if (*cursor == end)
+      return false;
+
+    unsigned char byte = *(*cursor)++;
+
+    value |= (uint64_t)(byte & 0x7f) << shift;
+
+    if ((byte & 0x80) == 0)
+    {
+      *out_value = value;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/**
+ * @brief      Reads and decodes the trace at `path`.
+ *
+ * @returns    `false` if the file can't be read or isn't a complete trace. The trace has to be
+ *             freed with `trace_file_free` either way.
+ */
+static bool trace_file_load(trace_file *trace, const char *path)
+{
+  FILE *file = fopen(path, "rb");
+
+  memset(trace, 0, sizeof(trace_file));
+
+  if (file == NULL)
+    return false;
+
+  size_t capacity = 1 << 20;
+
+  trace->data = (unsigned char *)malloc(capacity);
+
+  while (trace->data != NULL)
+  {
+    trace->size += fread(trace->data + trace->size, 1, capacity - trace->size, file);
+
+    if (trace->size < capacity)
+      break;
+
+    unsigned char *grown = (unsigned char *)realloc(trace->data, capacity * 2);
+
+    if (grown == NULL)
+      break;
+
+    trace->data = grown;
+    capacity *= 2;
+  }
+
+  bool read = trace->data != NULL && trace->size < capacity && !ferror(file);
+
+  fclose(file);
+
+  uint64_t magic;
+  uint32_t header[2];
+
+  if (!read || trace->size < sizeof(magic) + sizeof(header))
+    return false;
+
+  memcpy(&magic, trace->data, sizeof(magic));
+  memcpy(header, trace->data + sizeof(magic), sizeof(header));
+
+  if (magic != TRACE_FILE_MAGIC || header[0] != TRACE_FILE_VERSION || header[1] > TRACE_FILE_KEY_IDS)
+    return false;
+
+  trace->mode = (trace_file_mode)header[1];
+
+  const unsigned char *cursor = trace->data + sizeof(magic) + sizeof(header);
+  const unsigned char *end = trace->data + trace->size;
+  size_t synthetic_size = 0;
+
+  /* Every record takes at least 7 bytes, which bounds the number of operations. */
+  trace->ops = (trace_op *)malloc((trace->size / 7 + 1) * sizeof(trace_op));
+
+  if (trace->ops == NULL)
+    return false;
+
+  while (cursor < end)
+  {
+    trace_op *op = &trace->ops[trace->len];
+    uint64_t key_size;
+
+    op->kind = (trace_op_kind)*cursor++;
+
+    if (op->kind < TRACE_GET || op->kind >= TRACE_OPS_LEN ||
+        !trace_read_varint(&cursor, end, &key_size) || (size_t)(end - cursor) < sizeof(uint32_t))
+      return false;
+
+    memcpy(&op->hash, cursor, sizeof(uint32_t));
+    cursor += sizeof(uint32_t);
+
+    if (!trace_read_varint(&cursor, end, &op->value))
+      return false;
+
+    op->key_size = (size_t)key_size;
+    op->key = cursor;
+
+    if (op->kind == TRACE_RESERVE || op->kind == TRACE_CLEAR)
+    {
+      op->key_size = 0;
+    }
+    else if (trace->mode == TRACE_FILE_KEY_IDS)
+    {
+      if ((size_t)(end - cursor) < sizeof(uint64_t))
+        return false;
+
+      cursor += sizeof(uint64_t);
+      synthetic_size += op->key_size;
+    }
+    else
+    {
+      if ((size_t)(end - cursor) < key_size)
+        return false;
+
+      cursor += key_size;
+    }
+
+    trace->len++;
+  }
+
+  if (trace->mode == TRACE_FILE_KEY_IDS)
+  {
+    trace_short_key *short_keys = (trace_short_key *)malloc((trace->len + 1) * sizeof(trace_short_key));
+    size_t short_keys_len = 0;
+
+    trace->keys = (unsigned char *)malloc(synthetic_size + 1);
+
+    if (short_keys == NULL || trace->keys == NULL)
+    {
+      free(short_keys);
+      return false;
+    }
+
+    unsigned char *key = trace->keys;
+
+    for (size_t i = 0; i < trace->len; i++)
+    {
+      trace_op *op = &trace->ops[i];
+      uint64_t id;
+
+      if (op->kind == TRACE_RESERVE || op->kind == TRACE_CLEAR)
+        continue;
+
+      memcpy(&id, op->key, sizeof(id));
+
+      op->key = key;
+      key += op->key_size;
+
+      /* A cut fingerprint could make distinct short keys equal, so those are numbered below. */
+      if (op->key_size < sizeof(id))
+      {
+        trace_short_key *short_key = &short_keys[short_keys_len++];
+
+        short_key->id = id;
+        short_key->key_size = op->key_size;
+        short_key->key = (unsigned char *)op->key;
+        continue;
+      }
+
+      /* The fingerprint comes first, so keys of 8 bytes and more stay distinct. */
+      for (size_t offset = 0; offset < op->key_size; offset += sizeof(id))
+      {
+        size_t chunk = op->key_size - offset < sizeof(id) ? op->key_size - offset : sizeof(id);
+
+        memcpy((unsigned char *)op->key + offset, &id, chunk);
+        id = id * 0x9e3779b97f4a7c15 + 1;
+      }
+    }
+
+    qsort(short_keys, short_keys_len, sizeof(trace_short_key), trace_short_key_compare);
+
+    /* Distinct keys of a size number fewer than the values of that many bytes, so numbers fit. */
+    uint64_t number = 0;
+
+    for (size_t i = 0; i < short_keys_len; i++)
+    {
+      trace_short_key *current = &short_keys[i];
+
+      if (i > 0 && current->key_size != current[-1].key_size)
+        number = 0;
+      else if (i > 0 && current->id != current[-1].id)
+        number++;
+
+      for (size_t byte = 0; byte < current->key_size; byte++)
+      {
+        current->key[byte] = (unsigned char)(number >> (8 * byte));
+      }
+    }
+
+    free(short_keys);
+  }
+
+  return true;
+}
+
+static void trace_file_free(trace_file *trace)
+{
+  free(trace->data);
+  free(trace->keys);
+  free(trace->ops);
+}
+
+#endif /* _APPLE_MAP_TRACE_H_ */